@@ -1,12 +1,8 @@
 #include "NeuralNetwork.h"
 #include <iostream>
 
-typedef std::vector<nn::TrainingData> dataset;
-
-std::pair<dataset, dataset> LoadData();
-dataset LoadFromFile(const char* images, const char* labels, unsigned int capacity);
-void Evaluate(nn::NeuralNetwork& model, const dataset& data);
-void PrintImage(const std::vector<double>& image);
+void Evaluate(nn::NeuralNetwork& model, const nn::MappedDataset& data);
+void PrintImage(const unsigned char* image);
 
 // Switch to Release configuration
 // Download MNIST dataset and change paths
@@ -24,66 +20,37 @@ int main()
 		nn::Layer(64, 10, nn::activation::SOFTMAX)
 	}, nn::initialization::LECUN_UNIFORM, nn::loss::NLL);
 	//auto model = nn::NeuralNetwork::LoadModel("model.bin");
-	auto data = LoadData();
+	// The files are mapped, pixels are converted to [0, 1] a batch at a time during training
+	nn::MappedDataset trainingData = nn::MappedDataset::LoadIdx(TRAINING_IMAGES, TRAINING_LABELS, 10);
+	nn::MappedDataset testData = nn::MappedDataset::LoadIdx(TEST_IMAGES, TEST_LABELS, 10);
 	std::cout << "Dataset loaded." << std::endl;
-	model.Train(nn::optimizer::Adam(0.001), 10, data.first, 10, nn::regularizer::NONE);
+	nn::optimizer::Adam optimizer(0.001);
+	// Pixels of the next batches are converted on a loader thread while the current batch trains
+	model.SetPrefetch(4);
+	model.Train(optimizer, 10, trainingData, 10, nn::regularizer::NONE);
 	model.SaveModel("model.bin");
-	Evaluate(model, data.second);
+	Evaluate(model, testData);
 	std::cin.get();
 	return 0;
 }
 
-void Evaluate(nn::NeuralNetwork& model, const dataset& data)
+void Evaluate(nn::NeuralNetwork& model, const nn::MappedDataset& data)
 {
 	int correct = 0;
-	for (unsigned int i = 0; i < data.size(); ++i)
+	std::vector<nn::Output> predictions = model.Eval(data, 100);
+	for (unsigned int i = 0; i < data.GetSize(); ++i)
 	{
-		auto prediction = model.Eval(data[i].Inputs);
 		if (PRINT_TEST_IMAGES)
-			PrintImage(data[i].Inputs);
-		unsigned int predictionValue = prediction.Argmax;
-		unsigned int maxIndex = std::max_element(data[i].Target.begin(), data[i].Target.end()) - data[i].Target.begin();
-		std::cout << "Prediction: " << predictionValue << ", True: " << maxIndex << " " << (predictionValue == maxIndex ? "CORRECT" : "WRONG") << std::endl;;
-		if (predictionValue == maxIndex) correct++;
-	}
-	std::cout << "Correct: " << correct << " / " << data.size() << std::endl;
-}
-
-std::pair<dataset, dataset> LoadData()
-{
-	return{
-		LoadFromFile(TRAINING_IMAGES, TRAINING_LABELS, 60000),
-		LoadFromFile(TEST_IMAGES, TEST_LABELS, 10000)
-	};
-}
-
-dataset LoadFromFile(const char * images, const char * labels, unsigned int capacity)
-{
-	std::ifstream imageFIle;
-	imageFIle.open(images, std::ios::binary);
-	imageFIle.seekg(16, std::ios::beg);
-	std::ifstream labelsFile;
-	labelsFile.open(labels, std::ios::binary);
-	labelsFile.seekg(8, std::ios::beg);
-	dataset trainData;
-	for (unsigned int i = 0; i < capacity; ++i)
-	{
-		unsigned char* image = new unsigned char[784];
-		imageFIle.read(reinterpret_cast<char*>(image), sizeof(unsigned char) * 784);
-		unsigned char label;
-		labelsFile.read((char*)&label, sizeof(label));
-		std::vector<double> data;
-		std::for_each(image, image + 784, [&data](double x) { data.push_back(x / 255.0); });
-		std::vector<double> result(10);
-		std::fill(result.begin(), result.end(), 0);
-		result[label] = 1;
-		trainData.push_back({ data , result });
-		delete[] image;
+			PrintImage(data.GetInputs(i));
+		unsigned int predictionValue = predictions[i].Argmax;
+		unsigned int label = data.GetLabel(i);
+		std::cout << "Prediction: " << predictionValue << ", True: " << label << " " << (predictionValue == label ? "CORRECT" : "WRONG") << std::endl;;
+		if (predictionValue == label) correct++;
 	}
-	return trainData;
+	std::cout << "Correct: " << correct << " / " << data.GetSize() << std::endl;
 }
 
-void PrintImage(const std::vector<double>& image)
+void PrintImage(const unsigned char* image)
 {
 	for (size_t i = 0; i < 28; ++i)
 	{
@@ -20,12 +20,14 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>
 
 #pragma once
 #include <vector>
-#include <unordered_map>
+#include <random>
 #include "src/layers/Layer.h"
 #include "src/optimizers/Optimizers.h"
 #include "src/initializers/WeightInitializers.h"
 #include "src/losses/LossFunctions.h"
 #include "src/regularizers/Regularizers.h"
+#include "src/data/Dataset.h"
+#include "src/data/BatchPrefetcher.h"
 
 #ifdef _WINDLL // .dll or .lib
 #define PYTHON_API
@@ -35,50 +37,117 @@ namespace nn
 {
 	struct Output
 	{
-		double Value;
+		Scalar Value;
 		unsigned int Argmax;
-		Output(double v, unsigned int i) : Value(v), Argmax(i) {}
+		Output(Scalar v, unsigned int i) : Value(v), Argmax(i) {}
 	};
 
-	struct TrainingData
+	// How Train spreads the work over threadCount threads
+	enum class ParallelMode
 	{
-		std::vector<double> Inputs;
-		std::vector<double> Target;
-		TrainingData(const std::vector<double>& inputs, double target) : Inputs(inputs), Target({ target }) {}
-		TrainingData(const std::vector<double>& inputs, const std::vector<double>& target) : Inputs(inputs), Target(target) {}
-		TrainingData& operator=(const TrainingData& data)
-		{
-			Inputs = data.Inputs;
-			Target = data.Target;
-			return *this;
-		}
-		TrainingData(const TrainingData& data) noexcept : Inputs(data.Inputs), Target(data.Target) {}
-		TrainingData(TrainingData&& data) noexcept : Inputs(data.Inputs), Target(data.Target) {}
-		TrainingData(std::vector<double>&& inputs, std::vector<double>&& target) noexcept : Inputs(inputs), Target(target) {}
+		// Every batch is split into shards whose gradients are summed before a single update
+		SYNCHRONOUS,
+		// Hogwild!: every thread trains on its own part of the data with its own optimizer and updates the shared weights without locks
+		// Updates of different threads may overwrite each other, only GradientDescent and Momentum support it
+		HOGWILD
 	};
 
 	class NeuralNetwork
 	{
 	private:
+		// Buffers of one shard that Train allocates once and every batch reuses
+		struct ShardBuffers
+		{
+			// The samples of the shard, unless they were prefetched
+			Batch Gathered;
+			double Loss = 0;
+			unsigned int Count = 0;
+		};
+
 		unsigned int m_InputSize;
 		std::vector<Layer> m_Layers;
 		std::shared_ptr<initialization::Initializer> m_WeightInitializer;
 		std::shared_ptr<loss::LossFunction> m_LossFunction;
+		// Shuffles the training samples every epoch
+		std::mt19937 m_ShuffleEngine;
+		unsigned int m_PrefetchBatches;
+		unsigned int m_LoaderThreads;
+		// Weights and biases of every layer in one buffer that the layer matrices view, empty unless the network was flattened
+		std::vector<Scalar, math::WorkspaceAllocator<Scalar>> m_Parameters;
+		// Gradients of the last batch trained on, laid out like m_Parameters
+		std::vector<Scalar, math::WorkspaceAllocator<Scalar>> m_Gradients;
 
 	public:
 		NeuralNetwork(unsigned int inputSize, std::vector<Layer>&& layers, initialization::Type initializer, loss::Type lossFunction);
 		NeuralNetwork& operator=(NeuralNetwork&& net);
 		NeuralNetwork(NeuralNetwork&& net);
-		void Train(optimizer::Optimizer& optimizer, unsigned int epochs, const std::vector<TrainingData>& trainingData, unsigned int batchSize = 1, regularizer::Type regularizerType = regularizer::NONE);
-		Output Eval(const std::vector<double>& input);
-		Output Eval(std::vector<double>&& input);
-		Output operator()(const std::vector<double>& input);
+		// threadCount threads of the math thread pool share the training, 0 uses all of them
+		// In SYNCHRONOUS mode the shard gradients are summed in a fixed order, so the result depends on threadCount but not on thread scheduling
+		void Train(optimizer::Optimizer& optimizer, unsigned int epochs, const std::vector<TrainingData>& trainingData, unsigned int batchSize = 1,
+			regularizer::Type regularizerType = regularizer::NONE, unsigned int threadCount = 1, ParallelMode parallelMode = ParallelMode::SYNCHRONOUS);
+		void Train(optimizer::Optimizer& optimizer, unsigned int epochs, const Dataset& trainingData, unsigned int batchSize = 1,
+			regularizer::Type regularizerType = regularizer::NONE, unsigned int threadCount = 1, ParallelMode parallelMode = ParallelMode::SYNCHRONOUS);
+		void Train(optimizer::Optimizer& optimizer, unsigned int epochs, const MappedDataset& trainingData, unsigned int batchSize = 1,
+			regularizer::Type regularizerType = regularizer::NONE, unsigned int threadCount = 1, ParallelMode parallelMode = ParallelMode::SYNCHRONOUS);
+		Output Eval(const std::vector<Scalar>& input);
+		Output Eval(std::vector<Scalar>&& input);
+		Output Eval(const MatrixView& input);
+		Output Eval(const SparseMatrix& input);
+		// Every sample of data, batchSize samples go through the network at once
+		std::vector<Output> Eval(const Dataset& data, unsigned int batchSize);
+		std::vector<Output> Eval(const MappedDataset& data, unsigned int batchSize);
+		Output operator()(const std::vector<Scalar>& input);
+		// 16-bit weights for inference, 4x smaller in memory and in saved models than double, Train decompresses again
+		void Compress(math::StorageFormat format);
+		// int8 weights with a scale and zero point per row for inference, 8x smaller in memory than double
+		// The model is saved with the weights dequantized, Train decompresses again
+		void Quantize();
+		void Decompress();
+		// Moves the weights and biases of all layers into one contiguous buffer that the layer matrices view
+		// Training then keeps every shard's gradients in one matching buffer and sums them a buffer at a time, Compress and Quantize undo it
+		void Flatten();
+		inline bool IsFlat() const { return !m_Parameters.empty(); }
+		// Every layer's weights followed by its bias, each block starting on a cache line and rows padded like the layer's own
+		inline Scalar* GetParameters() { return m_Parameters.data(); }
+		inline const Scalar* GetGradients() const { return m_Gradients.data(); }
+		inline size_t GetParameterCount() const { return m_Parameters.size(); }
+		// Makes the sample order of later Train calls reproducible, the engine is seeded from std::random_device otherwise
+		void SetShuffleSeed(unsigned int seed);
+		// Later Train calls gather up to batches batches ahead on loaderThreads threads of their own while the current batch is trained on
+		// 0 batches, the default, gathers every batch when it is needed, Hogwild training always does
+		void SetPrefetch(unsigned int batches, unsigned int loaderThreads = 1);
 		void SaveModel(const char* fileName) const;
 		static NeuralNetwork LoadModel(const char* fileName);
 	private:
-		Matrix FeedForward(const std::vector<double>& input);
-		inline Matrix GetPreviousActivation(int layerIndex, const std::vector<double>& data) const;
-		std::unordered_map<unsigned int, std::pair<Matrix, Matrix>> Backpropagation(const std::vector<TrainingData>& batch, double& loss, unsigned int& numLoss);
+		// Epochs over data, a view of all samples in the order given by order, which is shuffled in place
+		void Train(optimizer::Optimizer& optimizer, unsigned int epochs, const BatchView& data, std::vector<unsigned int>& order, unsigned int batchSize,
+			regularizer::Type regularizerType, unsigned int threadCount, ParallelMode parallelMode);
+		std::vector<Output> Eval(const BatchView& data, unsigned int batchSize);
+		const Matrix& FeedForward(const MatrixView& input);
+		const Matrix& FeedForward(const SparseMatrix& input);
+		static Output GetOutput(const Matrix& output, unsigned int column = 0);
+		const Matrix& FeedForward(const MatrixView& input, std::vector<LayerState>& states) const;
+		const Matrix& FeedForward(const SparseMatrix& input, std::vector<LayerState>& states) const;
+		size_t GetFlatSize() const;
+		// Views of the weights and bias of every layer in a buffer laid out like m_Parameters
+		std::vector<std::pair<Matrix, Matrix>> CreateFlatViews(Scalar* buffer) const;
+		// Gives the layers storage of their own again and frees the flat buffers
+		void Unflatten();
+		inline MatrixView GetPreviousActivation(int layerIndex, const MatrixView& input, const std::vector<LayerState>& states) const;
+		// Adds scale times the gradients of the samples of batch to deltaWeightBias
+		void Backpropagation(const Batch& batch, Scalar scale, std::vector<LayerState>& states,
+			std::vector<std::pair<Matrix, Matrix>>& deltaWeightBias, double& loss, unsigned int& numLoss) const;
+		// Mean gradients of the batch in deltaWeightBias.front(), one shard of the batch per element of states
+		// The shards are taken from prefetched when it is given and gathered into buffers otherwise
+		void ParallelBackpropagation(const BatchView& batch, const std::vector<Batch>* prefetched, std::vector<std::vector<LayerState>>& states,
+			std::vector<std::vector<std::pair<Matrix, Matrix>>>& deltaWeightBias, std::vector<ShardBuffers>& buffers, double& loss, unsigned int& numLoss) const;
+		// One Hogwild epoch over the samples of data, thread i uses optimizers[i], states[i], deltaWeightBias[i] and buffers[i]
+		void HogwildEpoch(const BatchView& data, unsigned int batchSize, unsigned int epoch, std::vector<std::shared_ptr<optimizer::Optimizer>>& optimizers,
+			const regularizer::Regularizer& regularizer, std::vector<std::vector<LayerState>>& states,
+			std::vector<std::vector<std::pair<Matrix, Matrix>>>& deltaWeightBias, std::vector<ShardBuffers>& buffers, double& loss, unsigned int& numLoss);
+		// Regularizes the gradients and hands them to the optimizer, last layer first
+		void UpdateLayers(optimizer::Optimizer& optimizer, const regularizer::Regularizer& regularizer,
+			std::vector<std::pair<Matrix, Matrix>>& deltaWeightBias, unsigned int epoch);
 	};
 }
 
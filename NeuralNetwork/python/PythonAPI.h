@@ -286,7 +286,7 @@ NN_API void state_loaded(void* ptrOptimizer, unsigned int optimizer, unsigned in
 
 NN_API void add_training_sample(double inputs[], double targets[])
 {
-	trainingData.emplace_back(std::vector<double>(inputs, inputs + model.inputSize), std::vector<double>(targets, targets + model.outputSize));
+	trainingData.emplace_back(std::vector<Scalar>(inputs, inputs + model.inputSize), std::vector<Scalar>(targets, targets + model.outputSize));
 }
 
 NN_API void train(unsigned int epochs, unsigned int batchSize)
@@ -297,7 +297,11 @@ NN_API void train(unsigned int epochs, unsigned int batchSize)
 
 NN_API Output eval(double inputs[])
 {
-	nn::Output out = model.net->Eval(std::vector<double>(inputs, inputs + model.inputSize));
+#ifdef NN_SINGLE_PRECISION
+	nn::Output out = model.net->Eval(std::vector<Scalar>(inputs, inputs + model.inputSize));
+#else
+	nn::Output out = model.net->Eval(MatrixView(inputs, model.inputSize, 1));
+#endif // NN_SINGLE_PRECISION
 	Output o; o.value = out.Value; o.argmax = out.Argmax;
 	return o;
 }
\ No newline at end of file
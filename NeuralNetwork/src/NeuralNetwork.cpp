@@ -19,11 +19,41 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>
 */
 
 #include "../NeuralNetwork.h"
+#include "math/ThreadPool.h"
+#include "math/Gemm.h"
+#include <stdexcept>
+#include <numeric>
 
 namespace nn
 {
+	namespace
+	{
+		// Buffers of a flattened network are flatSize contiguous elements starting at the first weights
+		void ZeroOut(std::vector<std::pair<Matrix, Matrix>>& deltaWeightBias, size_t flatSize)
+		{
+			if (flatSize > 0)
+				std::fill(deltaWeightBias.front().first.GetData(), deltaWeightBias.front().first.GetData() + flatSize, (Scalar)0);
+			else
+				std::for_each(deltaWeightBias.begin(), deltaWeightBias.end(),
+					[](std::pair<Matrix, Matrix>& delta) { delta.first.ZeroOut(); delta.second.ZeroOut(); });
+		}
+
+		// Every block of a flat buffer starts on a cache line
+		size_t AlignOffset(size_t offset)
+		{
+			const size_t alignment = 64 / sizeof(Scalar);
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	// Model files start with this tag followed by the scalar size they were saved with
+	// A scalar size of 2 marks a compressed model and is followed by its storage format
+	// Files without it come from the original double-only format
+	static const unsigned int MODEL_FILE_TAG = 0x4D4E4E53;
+
 	NeuralNetwork::NeuralNetwork(unsigned int inputSize, std::vector<Layer>&& layers, initialization::Type initializer, loss::Type lossFunction)
-		: m_InputSize(inputSize), m_Layers(layers), m_WeightInitializer(WeightInitializerFactory::BuildWeightInitializer(initializer)), m_LossFunction(LossFunctionFactory::BuildLossFunction(lossFunction))
+		: m_InputSize(inputSize), m_Layers(std::move(layers)), m_WeightInitializer(WeightInitializerFactory::BuildWeightInitializer(initializer)), m_LossFunction(LossFunctionFactory::BuildLossFunction(lossFunction)),
+		m_ShuffleEngine(std::random_device()()), m_PrefetchBatches(0), m_LoaderThreads(1)
 	{
 		if (m_WeightInitializer != nullptr)
 			std::for_each(m_Layers.begin(), m_Layers.end(), [wi = m_WeightInitializer](Layer& layer) { layer.Initialize(wi); });
@@ -35,29 +65,73 @@ namespace nn
 		m_WeightInitializer = std::move(net.m_WeightInitializer);
 		m_LossFunction = std::move(net.m_LossFunction);
 		m_InputSize = net.m_InputSize;
+		m_ShuffleEngine = net.m_ShuffleEngine;
+		m_PrefetchBatches = net.m_PrefetchBatches;
+		m_LoaderThreads = net.m_LoaderThreads;
+		m_Parameters = std::move(net.m_Parameters);
+		m_Gradients = std::move(net.m_Gradients);
+		return *this;
 	}
 
 	NeuralNetwork::NeuralNetwork(NeuralNetwork && net)
-		: m_InputSize(net.m_InputSize), m_Layers(std::move(net.m_Layers)), m_WeightInitializer(m_WeightInitializer), m_LossFunction(net.m_LossFunction)
+		: m_InputSize(net.m_InputSize), m_Layers(std::move(net.m_Layers)), m_WeightInitializer(net.m_WeightInitializer), m_LossFunction(net.m_LossFunction),
+		m_ShuffleEngine(net.m_ShuffleEngine), m_PrefetchBatches(net.m_PrefetchBatches), m_LoaderThreads(net.m_LoaderThreads),
+		m_Parameters(std::move(net.m_Parameters)), m_Gradients(std::move(net.m_Gradients))
 	{
 		net.m_WeightInitializer = nullptr;
 	}
 
-	Output NeuralNetwork::Eval(const std::vector<double>& input)
+	Output NeuralNetwork::Eval(const std::vector<Scalar>& input)
+	{
+		return Eval(MatrixView(input));
+	}
+
+	Output NeuralNetwork::Eval(std::vector<Scalar>&& input)
 	{
-		std::vector<double> outputResults = FeedForward(input).GetColumnVector();
-		unsigned int maxIndex = std::max_element(outputResults.begin(), outputResults.end()) - outputResults.begin();
-		return{ outputResults[maxIndex], maxIndex };
+		return Eval(MatrixView(input));
 	}
 
-	Output NeuralNetwork::Eval(std::vector<double>&& input)
+	Output NeuralNetwork::Eval(const MatrixView& input)
 	{
-		std::vector<double> outputResults = FeedForward(input).GetColumnVector();
-		unsigned int maxIndex = std::max_element(outputResults.begin(), outputResults.end()) - outputResults.begin();
-		return{ outputResults[maxIndex], maxIndex };
+		return GetOutput(FeedForward(input));
 	}
 
-	Output NeuralNetwork::operator()(const std::vector<double>& input)
+	Output NeuralNetwork::Eval(const SparseMatrix& input)
+	{
+		return GetOutput(FeedForward(input));
+	}
+
+	std::vector<Output> NeuralNetwork::Eval(const Dataset& data, unsigned int batchSize)
+	{
+		std::vector<unsigned int> order(data.GetSize());
+		std::iota(order.begin(), order.end(), 0);
+		return Eval(BatchView(data, order.begin(), order.end()), batchSize);
+	}
+
+	std::vector<Output> NeuralNetwork::Eval(const MappedDataset& data, unsigned int batchSize)
+	{
+		std::vector<unsigned int> order(data.GetSize());
+		std::iota(order.begin(), order.end(), 0);
+		return Eval(BatchView(data, order.begin(), order.end()), batchSize);
+	}
+
+	std::vector<Output> NeuralNetwork::Eval(const BatchView& data, unsigned int batchSize)
+	{
+		std::vector<Output> outputs;
+		outputs.reserve(data.GetSize());
+		for (unsigned int batchBegin = 0; batchBegin < data.GetSize(); batchBegin += batchSize)
+		{
+			BatchView batch = data.Slice(batchBegin, std::min(data.GetSize(), batchBegin + batchSize));
+			Matrix inputs(m_InputSize, batch.GetSize(), 0);
+			batch.GatherInputs(inputs);
+			const Matrix& output = FeedForward(inputs);
+			for (unsigned int c = 0; c < batch.GetSize(); ++c)
+				outputs.push_back(GetOutput(output, c));
+		}
+		return outputs;
+	}
+
+	Output NeuralNetwork::operator()(const std::vector<Scalar>& input)
 	{
 		return Eval(input);
 	}
@@ -66,6 +140,16 @@ namespace nn
 	{
 		std::ofstream outfile;
 		outfile.open(fileName, std::ios::binary | std::ios::out);
+		unsigned int tag = MODEL_FILE_TAG;
+		outfile.write((char*)&tag, sizeof(tag));
+		const bool compressed = !m_Layers.empty() && m_Layers.front().IsCompressed();
+		unsigned int scalarSize = compressed ? sizeof(uint16_t) : sizeof(Scalar);
+		outfile.write((char*)&scalarSize, sizeof(scalarSize));
+		if (compressed)
+		{
+			math::StorageFormat format = m_Layers.front().CompressedWeights.GetFormat();
+			outfile.write((char*)&format, sizeof(format));
+		}
 		outfile.write((char*)&m_InputSize, sizeof(m_InputSize));
 		unsigned int numLayer = m_Layers.size();
 		outfile.write((char*)&numLayer, sizeof(numLayer));
@@ -82,84 +166,384 @@ namespace nn
 		infile.open(fileName, std::ios::in | std::ios::binary);
 		unsigned int inputSize;
 		infile.read((char*)&inputSize, sizeof(inputSize));
+		unsigned int scalarSize = sizeof(double);
+		math::StorageFormat format = math::FLOAT16;
+		if (inputSize == MODEL_FILE_TAG)
+		{
+			infile.read((char*)&scalarSize, sizeof(scalarSize));
+			if (scalarSize == sizeof(uint16_t))
+				infile.read((char*)&format, sizeof(format));
+			infile.read((char*)&inputSize, sizeof(inputSize));
+		}
 		unsigned int layerCount;
 		infile.read((char*)&layerCount, sizeof(layerCount));
 		int lossType;
 		infile.read((char*)&lossType, sizeof(lossType));
 		std::vector<Layer> layers;
+		layers.reserve(layerCount);
 		for (unsigned int i = 0; i < layerCount; ++i)
-			layers.push_back(Layer::LoadLayer(infile));
+			layers.push_back(Layer::LoadLayer(infile, scalarSize, format));
 		infile.close();
 		return NeuralNetwork(inputSize, std::move(layers), initialization::NONE, loss::Type(lossType));
 	}
 
-	Matrix NeuralNetwork::FeedForward(const std::vector<double>& input)
+	void NeuralNetwork::SetShuffleSeed(unsigned int seed)
+	{
+		m_ShuffleEngine.seed(seed);
+	}
+
+	void NeuralNetwork::SetPrefetch(unsigned int batches, unsigned int loaderThreads)
+	{
+		m_PrefetchBatches = batches;
+		m_LoaderThreads = std::max(1u, loaderThreads);
+	}
+
+	void NeuralNetwork::Compress(math::StorageFormat format)
+	{
+		Unflatten();
+		std::for_each(m_Layers.begin(), m_Layers.end(), [format](Layer& layer) { layer.Compress(format); });
+	}
+
+	void NeuralNetwork::Quantize()
 	{
-		Matrix inputMatrix(input);
-		std::for_each(m_Layers.begin(), m_Layers.end(), [&inputMatrix](Layer& layer) { inputMatrix = layer.UpdateActivation(inputMatrix); });
-		return inputMatrix;
+		Unflatten();
+		std::for_each(m_Layers.begin(), m_Layers.end(), [](Layer& layer) { layer.Quantize(); });
 	}
 
-	inline Matrix NeuralNetwork::GetPreviousActivation(int layerIndex, const std::vector<double>& inputs) const
+	void NeuralNetwork::Unflatten()
 	{
-		return layerIndex == 0 ? Matrix(inputs) : m_Layers[layerIndex - 1].Activation;
+		if (!IsFlat())
+			return;
+		for (Layer& layer : m_Layers)
+		{
+			// A matrix of the view's own shape would be written through, an empty one replaces the view
+			Matrix weights(layer.WeightMatrix), bias(layer.BiasMatrix);
+			layer.WeightMatrix = Matrix();
+			layer.BiasMatrix = Matrix();
+			layer.WeightMatrix = std::move(weights);
+			layer.BiasMatrix = std::move(bias);
+		}
+		std::vector<Scalar, math::WorkspaceAllocator<Scalar>>().swap(m_Parameters);
+		std::vector<Scalar, math::WorkspaceAllocator<Scalar>>().swap(m_Gradients);
+	}
+
+	void NeuralNetwork::Decompress()
+	{
+		std::for_each(m_Layers.begin(), m_Layers.end(), [](Layer& layer) { layer.Decompress(); });
 	}
 
-	std::unordered_map<unsigned int, std::pair<Matrix, Matrix>> NeuralNetwork::Backpropagation(const std::vector<TrainingData>& batch, double & loss, unsigned int& numLoss)
+	void NeuralNetwork::Flatten()
 	{
-		std::unordered_map<unsigned int, std::pair<Matrix, Matrix>> deltaWeightBias;
-		std::for_each(batch.begin(), batch.end(), [this, &loss, &numLoss, &deltaWeightBias](const TrainingData& data)
+		if (IsFlat())
+			return;
+		Decompress();
+		std::vector<Scalar, math::WorkspaceAllocator<Scalar>> parameters(GetFlatSize(), 0);
+		std::vector<std::pair<Matrix, Matrix>> views = CreateFlatViews(parameters.data());
+		for (unsigned int i = 0; i < m_Layers.size(); ++i)
 		{
-			Matrix prediction = FeedForward(data.Inputs);
-			Matrix error = m_LossFunction->GetDerivative(prediction, data.Target);
-			loss += m_LossFunction->GetLoss(prediction, data.Target);
-			unsigned int layerIndex = m_Layers.size() - 1;
-			std::for_each(m_Layers.rbegin(), m_Layers.rend(), [this, &error, &layerIndex, &data, &deltaWeightBias](Layer& layer)
+			// Copying keeps the views, moving them into the layers replaces the layers' own storage
+			views[i].first = m_Layers[i].WeightMatrix;
+			views[i].second = m_Layers[i].BiasMatrix;
+			m_Layers[i].WeightMatrix = std::move(views[i].first);
+			m_Layers[i].BiasMatrix = std::move(views[i].second);
+		}
+		m_Parameters = std::move(parameters);
+		m_Gradients.assign(m_Parameters.size(), 0);
+	}
+
+	size_t NeuralNetwork::GetFlatSize() const
+	{
+		size_t size = 0;
+		for (const Layer& layer : m_Layers)
+		{
+			size = AlignOffset(size + (size_t)layer.WeightMatrix.GetHeight()*Matrix::PaddedStride(layer.WeightMatrix.GetWidth()));
+			size = AlignOffset(size + layer.BiasMatrix.GetHeight());
+		}
+		return size;
+	}
+
+	std::vector<std::pair<Matrix, Matrix>> NeuralNetwork::CreateFlatViews(Scalar* buffer) const
+	{
+		std::vector<std::pair<Matrix, Matrix>> views;
+		views.reserve(m_Layers.size());
+		size_t offset = 0;
+		for (const Layer& layer : m_Layers)
+		{
+			const unsigned int rows = layer.WeightMatrix.GetHeight();
+			const unsigned int stride = Matrix::PaddedStride(layer.WeightMatrix.GetWidth());
+			Matrix weights = Matrix::View(buffer + offset, rows, layer.WeightMatrix.GetWidth(), stride);
+			offset = AlignOffset(offset + (size_t)rows*stride);
+			Matrix bias = Matrix::View(buffer + offset, rows, 1, 1);
+			offset = AlignOffset(offset + rows);
+			views.emplace_back(std::move(weights), std::move(bias));
+		}
+		return views;
+	}
+
+	const Matrix& NeuralNetwork::FeedForward(const MatrixView& input)
+	{
+		MatrixView layerInput = input;
+		std::for_each(m_Layers.begin(), m_Layers.end(), [&layerInput](Layer& layer) { layerInput = layer.UpdateActivation(layerInput); });
+		return m_Layers.back().Activation;
+	}
+
+	const Matrix& NeuralNetwork::FeedForward(const SparseMatrix& input)
+	{
+		MatrixView layerInput = m_Layers.front().UpdateActivation(input);
+		std::for_each(m_Layers.begin() + 1, m_Layers.end(), [&layerInput](Layer& layer) { layerInput = layer.UpdateActivation(layerInput); });
+		return m_Layers.back().Activation;
+	}
+
+	Output NeuralNetwork::GetOutput(const Matrix& output, unsigned int column)
+	{
+		// The output is owned by the last layer, so the column is searched in place
+		const Scalar* outputResults = output.GetData() + column;
+		unsigned int maxIndex = 0;
+		for (unsigned int i = 1; i < output.GetHeight(); ++i)
+			if (outputResults[(size_t)i*output.GetStride()] > outputResults[(size_t)maxIndex*output.GetStride()])
+				maxIndex = i;
+		return{ outputResults[(size_t)maxIndex*output.GetStride()], maxIndex };
+	}
+
+	const Matrix& NeuralNetwork::FeedForward(const MatrixView& input, std::vector<LayerState>& states) const
+	{
+		MatrixView layerInput = input;
+		for (unsigned int i = 0; i < m_Layers.size(); ++i)
+			layerInput = m_Layers[i].UpdateActivation(layerInput, states[i]);
+		return states.back().Activation;
+	}
+
+	const Matrix& NeuralNetwork::FeedForward(const SparseMatrix& input, std::vector<LayerState>& states) const
+	{
+		MatrixView layerInput = m_Layers.front().UpdateActivation(input, states.front());
+		for (unsigned int i = 1; i < m_Layers.size(); ++i)
+			layerInput = m_Layers[i].UpdateActivation(layerInput, states[i]);
+		return states.back().Activation;
+	}
+
+	inline MatrixView NeuralNetwork::GetPreviousActivation(int layerIndex, const MatrixView& input, const std::vector<LayerState>& states) const
+	{
+		return layerIndex == 0 ? input : MatrixView(states[layerIndex - 1].Activation);
+	}
+
+	void NeuralNetwork::Backpropagation(const Batch& batch, Scalar scale, std::vector<LayerState>& states,
+		std::vector<std::pair<Matrix, Matrix>>& deltaWeightBias, double & loss, unsigned int& numLoss) const
+	{
+		// The samples go through the network at once, every activation holds one column per sample
+		const Matrix& inputs = batch.Inputs;
+		const Matrix& targets = batch.Targets;
+		const SparseMatrix& sparseInputs = batch.SparseInputs;
+		const bool sparse = batch.Sparse;
+		const unsigned int batchSize = targets.GetWidth();
+		const Matrix& prediction = sparse ? FeedForward(sparseInputs, states) : FeedForward(inputs, states);
+		Matrix error = m_LossFunction->GetDerivative(prediction, targets);
+		loss += m_LossFunction->GetLoss(prediction, targets);
+		numLoss += batchSize;
+		unsigned int layerIndex = m_Layers.size() - 1;
+		std::for_each(m_Layers.rbegin(), m_Layers.rend(), [this, &error, &layerIndex, &inputs, &sparseInputs, sparse, scale, &states, &deltaWeightBias](const Layer& layer)
+		{
+			// The products sum the gradients over the samples
+			Matrix gradient = m_LossFunction->Backward(states[layerIndex], error);
+			std::pair<Matrix, Matrix>& delta = deltaWeightBias[layerIndex];
+			delta.second.AddRowSums(gradient, scale);
+			// Only the weight columns of the nonzero inputs receive a gradient from a sparse batch
+			if (layerIndex == 0 && sparse)
+				delta.first.AddMultiply(gradient, sparseInputs, scale);
+			else
+				delta.first.AddMultiplyTranspose(gradient, GetPreviousActivation(layerIndex, inputs, states), scale);
+			// Nothing consumes the error below the first layer
+			if (layerIndex > 0)
+				m_LossFunction->PropagateError(layer, error);
+			layerIndex--;
+		});
+	}
+
+	void NeuralNetwork::ParallelBackpropagation(const BatchView& batch, const std::vector<Batch>* prefetched, std::vector<std::vector<LayerState>>& states,
+		std::vector<std::vector<std::pair<Matrix, Matrix>>>& deltaWeightBias, std::vector<ShardBuffers>& buffers, double & loss, unsigned int& numLoss) const
+	{
+		math::ThreadPool& pool = math::ThreadPool::GetInstance();
+		const unsigned int shards = std::min<unsigned int>(states.size(), batch.GetSize());
+		const Scalar scale = (Scalar)1 / batch.GetSize();
+		auto runShard = [this, &batch, prefetched, &states, &deltaWeightBias, &buffers, shards, scale](unsigned int shard)
+		{
+			ShardBuffers& shardBuffers = buffers[shard];
+			shardBuffers.Loss = 0;
+			shardBuffers.Count = 0;
+			ZeroOut(deltaWeightBias[shard], m_Parameters.size());
+			if (prefetched != nullptr)
 			{
-				Matrix gradient = m_LossFunction->Backward(layer, error);
-				Matrix previousActivation = GetPreviousActivation(layerIndex, data.Inputs);
-				if (deltaWeightBias.find(layerIndex) == deltaWeightBias.end())
+				Backpropagation((*prefetched)[shard], scale, states[shard], deltaWeightBias[shard], shardBuffers.Loss, shardBuffers.Count);
+				return;
+			}
+			batch.Slice(batch.GetSize()*shard / shards, batch.GetSize()*(shard + 1) / shards).Gather(shardBuffers.Gathered, m_InputSize);
+			Backpropagation(shardBuffers.Gathered, scale, states[shard], deltaWeightBias[shard], shardBuffers.Loss, shardBuffers.Count);
+		};
+		if (shards == 1)
+			runShard(0);
+		else
+			pool.ParallelFor(shards, runShard);
+		// Pairwise tree reduction in a fixed order, the sums do not depend on which thread finished first
+		for (unsigned int step = 1; step < shards; step *= 2)
+		{
+			const unsigned int pairs = (shards - step + 2 * step - 1) / (2 * step);
+			pool.ParallelFor(pairs, [this, &deltaWeightBias, step](unsigned int pair)
+			{
+				std::vector<std::pair<Matrix, Matrix>>& target = deltaWeightBias[2 * step*pair];
+				std::vector<std::pair<Matrix, Matrix>>& source = deltaWeightBias[2 * step*pair + step];
+				// Flat buffers are summed in one pass
+				if (IsFlat())
 				{
-					deltaWeightBias[layerIndex] = std::make_pair(gradient*previousActivation.Transpose(), gradient);
+					math::Axpy(m_Parameters.size(), (Scalar)1, source.front().first.GetData(), 1, target.front().first.GetData(), 1);
+					return;
 				}
-				else
+				for (unsigned int i = 0; i < target.size(); ++i)
 				{
-					deltaWeightBias[layerIndex].first += gradient*previousActivation.Transpose();
-					deltaWeightBias[layerIndex].second += gradient;
+					target[i].first += source[i].first;
+					target[i].second += source[i].second;
 				}
-				m_LossFunction->PropagateError(layer, error);
-				layerIndex--;
 			});
-			numLoss++;
+			for (unsigned int shard = 0; shard + step < shards; shard += 2 * step)
+			{
+				buffers[shard].Loss += buffers[shard + step].Loss;
+				buffers[shard].Count += buffers[shard + step].Count;
+			}
+		}
+		loss += buffers[0].Loss;
+		numLoss += buffers[0].Count;
+	}
+
+	void NeuralNetwork::HogwildEpoch(const BatchView& data, unsigned int batchSize, unsigned int epoch, std::vector<std::shared_ptr<optimizer::Optimizer>>& optimizers,
+		const regularizer::Regularizer& regularizer, std::vector<std::vector<LayerState>>& states,
+		std::vector<std::vector<std::pair<Matrix, Matrix>>>& deltaWeightBias, std::vector<ShardBuffers>& buffers, double & loss, unsigned int& numLoss)
+	{
+		// Threads read and write the shared layers with no synchronization at all, a step that races with another one may be partly lost
+		const unsigned int threads = optimizers.size();
+		math::ThreadPool::GetInstance().ParallelFor(threads, [this, &data, batchSize, epoch, &optimizers, &regularizer, &states, &deltaWeightBias, &buffers, threads](unsigned int thread)
+		{
+			std::vector<std::pair<Matrix, Matrix>>& delta = deltaWeightBias[thread];
+			ShardBuffers& threadBuffers = buffers[thread];
+			threadBuffers.Loss = 0;
+			threadBuffers.Count = 0;
+			const unsigned int end = data.GetSize()*(thread + 1) / threads;
+			for (unsigned int batchBegin = data.GetSize()*thread / threads; batchBegin < end; batchBegin += batchSize)
+			{
+				BatchView batch = data.Slice(batchBegin, std::min(end, batchBegin + batchSize));
+				ZeroOut(delta, m_Parameters.size());
+				batch.Gather(threadBuffers.Gathered, m_InputSize);
+				Backpropagation(threadBuffers.Gathered, (Scalar)1 / batch.GetSize(), states[thread], delta, threadBuffers.Loss, threadBuffers.Count);
+				UpdateLayers(*optimizers[thread], regularizer, delta, epoch);
+			}
+			// Frees the optimizer state on the thread that built it
+			optimizers[thread]->Reset();
 		});
-		std::for_each(deltaWeightBias.begin(), deltaWeightBias.end(), [len = batch.size()]
-		(std::pair<const unsigned int, std::pair<Matrix, Matrix>>& dWB) { dWB.second.first /= len; dWB.second.second /= len; });
-		return deltaWeightBias;
+		for (unsigned int thread = 0; thread < threads; ++thread)
+		{
+			loss += buffers[thread].Loss;
+			numLoss += buffers[thread].Count;
+		}
+	}
+
+	void NeuralNetwork::UpdateLayers(optimizer::Optimizer& optimizer, const regularizer::Regularizer& regularizer,
+		std::vector<std::pair<Matrix, Matrix>>& deltaWeightBias, unsigned int epoch)
+	{
+		for (int layerIndex = m_Layers.size() - 1; layerIndex >= 0; --layerIndex)
+		{
+			regularizer.Regularize(m_Layers[layerIndex].WeightMatrix, deltaWeightBias[layerIndex].first);
+			optimizer.UpdateLayer(m_Layers[layerIndex], deltaWeightBias[layerIndex].first, deltaWeightBias[layerIndex].second, layerIndex, epoch);
+		}
+	}
+
+	void NeuralNetwork::Train(optimizer::Optimizer& optimizer, unsigned int epochs, const std::vector<TrainingData>& trainingData, unsigned int batchSize,
+		regularizer::Type regularizerType, unsigned int threadCount, ParallelMode parallelMode)
+	{
+		// Only the order of the samples is shuffled, batches are ranges of it
+		std::vector<unsigned int> order(trainingData.size());
+		std::iota(order.begin(), order.end(), 0);
+		Train(optimizer, epochs, BatchView(trainingData, order.begin(), order.end()), order, batchSize, regularizerType, threadCount, parallelMode);
 	}
 
-	void NeuralNetwork::Train(optimizer::Optimizer& optimizer, unsigned int epochs, const std::vector<TrainingData>& trainingData, unsigned int batchSize, regularizer::Type regularizerType)
+	void NeuralNetwork::Train(optimizer::Optimizer& optimizer, unsigned int epochs, const Dataset& trainingData, unsigned int batchSize,
+		regularizer::Type regularizerType, unsigned int threadCount, ParallelMode parallelMode)
+	{
+		std::vector<unsigned int> order(trainingData.GetSize());
+		std::iota(order.begin(), order.end(), 0);
+		Train(optimizer, epochs, BatchView(trainingData, order.begin(), order.end()), order, batchSize, regularizerType, threadCount, parallelMode);
+	}
+
+	void NeuralNetwork::Train(optimizer::Optimizer& optimizer, unsigned int epochs, const MappedDataset& trainingData, unsigned int batchSize,
+		regularizer::Type regularizerType, unsigned int threadCount, ParallelMode parallelMode)
+	{
+		std::vector<unsigned int> order(trainingData.GetSize());
+		std::iota(order.begin(), order.end(), 0);
+		Train(optimizer, epochs, BatchView(trainingData, order.begin(), order.end()), order, batchSize, regularizerType, threadCount, parallelMode);
+	}
+
+	void NeuralNetwork::Train(optimizer::Optimizer& optimizer, unsigned int epochs, const BatchView& data, std::vector<unsigned int>& order, unsigned int batchSize,
+		regularizer::Type regularizerType, unsigned int threadCount, ParallelMode parallelMode)
 	{
 		std::shared_ptr<regularizer::Regularizer> regularizer = RegularizerFactory::BuildRegularizer(regularizerType);
+		Decompress();
+		// Every shard of a batch gets its own forward state and gradient buffers, the weights are shared and only read
+		// A Hogwild thread trains on a shard of the whole data set instead and also gets its own optimizer
+		const bool hogwild = parallelMode == ParallelMode::HOGWILD;
+		const unsigned int threads = threadCount == 0 ? math::ThreadPool::GetInstance().GetThreadCount() : threadCount;
+		const unsigned int shards = std::max(1u, std::min(threads, hogwild ? data.GetSize() : batchSize));
+		std::vector<std::shared_ptr<optimizer::Optimizer>> optimizers;
+		for (unsigned int shard = 0; hogwild && shard < shards; ++shard)
+		{
+			optimizers.push_back(optimizer.Clone());
+			if (optimizers.back() == nullptr)
+				throw std::invalid_argument("Hogwild training supports only GradientDescent and Momentum!");
+		}
+		std::vector<std::vector<LayerState>> states(shards);
+		std::vector<ShardBuffers> buffers(shards);
+		// Gradient buffers are indexed by layer, allocated once here and zeroed in place before every batch
+		// A flattened network gives every shard one buffer laid out like its parameters, the first shard's is m_Gradients
+		std::vector<std::vector<std::pair<Matrix, Matrix>>> deltaWeightBias(shards);
+		std::vector<std::vector<Scalar, math::WorkspaceAllocator<Scalar>>> flatGradients(IsFlat() ? shards - 1 : 0,
+			std::vector<Scalar, math::WorkspaceAllocator<Scalar>>(m_Parameters.size(), 0));
+		for (unsigned int shard = 0; shard < shards; ++shard)
+		{
+			if (IsFlat())
+				deltaWeightBias[shard] = CreateFlatViews(shard == 0 ? m_Gradients.data() : flatGradients[shard - 1].data());
+			for (unsigned int i = 0; i < m_Layers.size(); ++i)
+			{
+				const Matrix& weights = m_Layers[i].WeightMatrix;
+				states[shard].push_back(m_Layers[i].CreateState());
+				if (!IsFlat())
+					deltaWeightBias[shard].emplace_back(Matrix(weights.GetHeight(), weights.GetWidth(), 0, weights.GetStride()), Matrix(weights.GetHeight(), 1, 0));
+			}
+		}
+		// The loaders only read order and the data set, the weights are never touched outside this thread and the pool
+		// They are started once, so their gathered batches are reused from epoch to epoch
+		std::unique_ptr<BatchPrefetcher> prefetcher;
+		if (!hogwild && m_PrefetchBatches > 0)
+			prefetcher.reset(new BatchPrefetcher(data, batchSize, shards, m_InputSize, m_PrefetchBatches, m_LoaderThreads));
 		for (unsigned int epoch = 1; epoch <= epochs; epoch++)
 		{
 			double fullLoss = 0;
 			unsigned int numLoss = 0;
 			optimizer.Reset();
-			std::vector<TrainingData> temp(trainingData);
-			std::random_shuffle(temp.begin(), temp.end());
-			std::vector<TrainingData>::iterator batchEnd;
-			for (std::vector<TrainingData>::iterator batchBegin = temp.begin(); batchBegin != temp.end(); batchBegin = batchEnd)
+			std::shuffle(order.begin(), order.end(), m_ShuffleEngine);
+			if (hogwild)
+				HogwildEpoch(data, batchSize, epoch, optimizers, *regularizer, states, deltaWeightBias, buffers, fullLoss, numLoss);
+			else if (prefetcher != nullptr)
 			{
-				batchEnd = (unsigned)(temp.end() - batchBegin) >= batchSize ? batchBegin + batchSize : temp.end();
-				std::vector<TrainingData> batch{ batchBegin, batchEnd };
-				std::unordered_map<unsigned int, std::pair<Matrix, Matrix>> deltaWeightBias = Backpropagation(batch, fullLoss, numLoss);
-				int layerIndex = m_Layers.size() - 1;
-				std::for_each(m_Layers.rbegin(), m_Layers.rend(), [this, &batch, &deltaWeightBias, epoch, &optimizer, &layerIndex, &regularizer](Layer& layer)
+				prefetcher->StartEpoch();
+				for (unsigned int batch = 0; batch < prefetcher->GetBatchCount(); ++batch)
 				{
-					regularizer->Regularize(layer.WeightMatrix, deltaWeightBias[layerIndex].first);
-					optimizer.UpdateLayer(layer, deltaWeightBias[layerIndex].first, deltaWeightBias[layerIndex].second, layerIndex--, epoch);
-				});
+					ParallelBackpropagation(data.Slice(batch*batchSize, std::min(data.GetSize(), (batch + 1)*batchSize)), &prefetcher->Acquire(batch),
+						states, deltaWeightBias, buffers, fullLoss, numLoss);
+					prefetcher->Release(batch);
+					UpdateLayers(optimizer, *regularizer, deltaWeightBias.front(), epoch);
+				}
 			}
+			else
+				for (unsigned int batchBegin = 0; batchBegin < data.GetSize(); batchBegin += batchSize)
+				{
+					ParallelBackpropagation(data.Slice(batchBegin, std::min(data.GetSize(), batchBegin + batchSize)), nullptr, states, deltaWeightBias, buffers, fullLoss, numLoss);
+					UpdateLayers(optimizer, *regularizer, deltaWeightBias.front(), epoch);
+				}
 			std::cout << "Epoch: " << epoch << " Loss: " << fullLoss / numLoss << std::endl;
 		}
 	}
@@ -61,9 +61,9 @@ namespace nn
 		class LeakyReLu : public ActivationFunction
 		{
 		private:
-			double alpha;
+			Scalar alpha;
 		public:
-			LeakyReLu(double alpha = 0.1);
+			LeakyReLu(Scalar alpha = 0.1);
 			Matrix Function(Matrix& x) override;
 			Matrix Derivative(Matrix& x) override;
 			Type GetType() const override;
@@ -72,9 +72,9 @@ namespace nn
 		class ELu : public ActivationFunction
 		{
 		private:
-			double alpha;
+			Scalar alpha;
 		public:
-			ELu(double alpha = 0.1);
+			ELu(Scalar alpha = 0.1);
 			Matrix Function(Matrix& x) override;
 			Matrix Derivative(Matrix& x) override;
 			Type GetType() const override;
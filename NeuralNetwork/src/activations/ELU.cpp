@@ -24,18 +24,23 @@ namespace nn
 {
 	namespace activation
 	{
-		ELu::ELu(double alpha) : alpha(alpha)
+		ELu::ELu(Scalar alpha) : alpha(alpha)
 		{
 		}
 
 		Matrix ELu::Function(Matrix& x)
 		{
-			return x.Map([alph=alpha](double a) { return a >= 0 ? a : alph*(exp(a) - 1); });
+			// max(a, 0) + alpha * (exp(min(a, 0)) - 1), so the exponential runs over the whole matrix in one vectorized pass
+			Matrix exponential = Matrix::Map(x, [](Scalar a) { return std::min(a, (Scalar)0); });
+			exponential.Exp() -= 1;
+			return x = Matrix::Map(x, [](Scalar a) { return std::max(a, (Scalar)0); }) + alpha * exponential;
 		}
 
 		Matrix ELu::Derivative(Matrix& x)
 		{
-			return x.Map([alph=alpha](double a) { return a >= 0 ? 1 : alph*exp(a); });
+			Matrix exponential = Matrix::Map(x, [](Scalar a) { return std::min(a, (Scalar)0); });
+			exponential.Exp();
+			return x = Matrix::DotProduct(Matrix::Map(x, [alph=alpha](Scalar a) { return a >= 0 ? 1 : alph; }), exponential);
 		}
 
 		Type ELu::GetType() const
@@ -24,18 +24,18 @@ namespace nn
 {
 	namespace activation
 	{
-		LeakyReLu::LeakyReLu(double alpha) : alpha(alpha)
+		LeakyReLu::LeakyReLu(Scalar alpha) : alpha(alpha)
 		{
 		}
 
 		Matrix LeakyReLu::Function(Matrix& x)
 		{
-			return x.Map([alph=alpha](double a) { return a >= alph*a ? a : alph; });
+			return x.Map([alph=alpha](Scalar a) { return a >= alph*a ? a : alph; });
 		}
 
 		Matrix LeakyReLu::Derivative(Matrix& x)
 		{
-			return x.Map([alph=alpha](double a) { return a >= alph*a ? 1 : 0; });
+			return x.Map([alph=alpha](Scalar a) { return a >= alph*a ? 1 : 0; });
 		}
 
 		Type LeakyReLu::GetType() const
@@ -26,13 +26,13 @@ namespace nn
 	{
 		Matrix Sigmoid::Function(Matrix& x)
 		{
-			m_Activation = x.Map([](double a) { return 1 / (1 + exp(-a)); });
+			m_Activation = x.Sigmoid();
 			return m_Activation;
 		}
 
 		Matrix Sigmoid::Derivative(Matrix& x)
 		{
-			return m_Activation.Map([](double a) { return a * (1 - a); });
+			return m_Activation.Map([](Scalar a) { return a * (1 - a); });
 		}
 		Type Sigmoid::GetType() const
 		{
@@ -26,13 +26,13 @@ namespace nn
 	{
 		Matrix Tanh::Function(Matrix& x)
 		{
-			m_Activation = x.Map([](double a) { return (exp(a) - exp(-a)) / (exp(a) + exp(-a)); });
+			m_Activation = x.Tanh();
 			return m_Activation;
 		}
 
 		Matrix Tanh::Derivative(Matrix& x)
 		{
-			return m_Activation.Map([](double a) { return 1 - pow(a, 2); });
+			return m_Activation.Map([](Scalar a) { return 1 - pow(a, 2); });
 		}
 
 		Type Tanh::GetType() const
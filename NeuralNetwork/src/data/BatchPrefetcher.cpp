@@ -0,0 +1,115 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "BatchPrefetcher.h"
+#include <algorithm>
+
+namespace nn
+{
+	BatchPrefetcher::BatchPrefetcher(const BatchView& data, unsigned int batchSize, unsigned int shardCount, unsigned int inputSize, unsigned int capacity, unsigned int loaderCount)
+		: m_Data(data), m_BatchSize(batchSize), m_ShardCount(shardCount), m_InputSize(inputSize), m_BatchCount((data.GetSize() + batchSize - 1) / batchSize),
+		m_Capacity((std::max(capacity, loaderCount) + loaderCount - 1) / loaderCount * loaderCount), m_Slots(new Slot[m_Capacity]), m_Epoch(0), m_Finished(false)
+	{
+		for (unsigned int loader = 0; loader < loaderCount; ++loader)
+			m_Loaders.emplace_back(&BatchPrefetcher::Load, this, loader, loaderCount);
+	}
+
+	BatchPrefetcher::~BatchPrefetcher()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Finished = true;
+		}
+		m_SlotFreed.notify_all();
+		std::for_each(m_Loaders.begin(), m_Loaders.end(), [](std::thread& loader) { loader.join(); });
+	}
+
+	void BatchPrefetcher::StartEpoch()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			for (unsigned int slot = 0; slot < m_Capacity; ++slot)
+				m_Slots[slot].Sequence = 2 * slot;
+			++m_Epoch;
+		}
+		m_SlotFreed.notify_all();
+	}
+
+	void BatchPrefetcher::Load(unsigned int loader, unsigned int loaderCount)
+	{
+		unsigned int epoch = 0;
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		while (true)
+		{
+			m_SlotFreed.wait(lock, [this, epoch]() { return m_Finished || m_Epoch != epoch; });
+			if (m_Finished)
+				break;
+			epoch = m_Epoch;
+			// Loader i gathers batches i, i + loaderCount, ... so slot k % capacity is only ever written by this thread
+			for (unsigned int batch = loader; batch < m_BatchCount; batch += loaderCount)
+			{
+				Slot& slot = m_Slots[batch % m_Capacity];
+				m_SlotFreed.wait(lock, [this, &slot, batch]() { return m_Finished || slot.Sequence == 2 * batch; });
+				if (m_Finished)
+					break;
+				lock.unlock();
+				slot.Error = nullptr;
+				try
+				{
+					BatchView data = m_Data.Slice(batch*m_BatchSize, std::min(m_Data.GetSize(), (batch + 1)*m_BatchSize));
+					const unsigned int shards = std::min(m_ShardCount, data.GetSize());
+					slot.Shards.resize(m_ShardCount);
+					for (unsigned int shard = 0; shard < shards; ++shard)
+						data.Slice(data.GetSize()*shard / shards, data.GetSize()*(shard + 1) / shards).Gather(slot.Shards[shard], m_InputSize);
+				}
+				catch (...)
+				{
+					slot.Error = std::current_exception();
+				}
+				lock.lock();
+				slot.Sequence = 2 * batch + 1;
+				m_BatchGathered.notify_all();
+			}
+		}
+		lock.unlock();
+		// The batches were allocated on this thread and go back to its own free lists
+		for (unsigned int slot = loader; slot < m_Capacity; slot += loaderCount)
+			m_Slots[slot].Shards.clear();
+	}
+
+	const std::vector<Batch>& BatchPrefetcher::Acquire(unsigned int batch)
+	{
+		Slot& slot = m_Slots[batch % m_Capacity];
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_BatchGathered.wait(lock, [&slot, batch]() { return slot.Sequence == 2 * batch + 1; });
+		if (slot.Error != nullptr)
+			std::rethrow_exception(slot.Error);
+		return slot.Shards;
+	}
+
+	void BatchPrefetcher::Release(unsigned int batch)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Slots[batch % m_Capacity].Sequence = 2 * (batch + m_Capacity);
+		}
+		m_SlotFreed.notify_all();
+	}
+}
@@ -0,0 +1,79 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Dataset.h"
+
+namespace nn
+{
+	// Gathers the batches of every epoch ahead of training on loader threads that live as long as the prefetcher
+	// Batch k goes to slot k % capacity, and the slot's sequence number says whether it is free for batch k (2k) or holds it (2k + 1)
+	// Every slot is filled by one loader and read by one consumer, waiting on either side blocks on a condition variable
+	class BatchPrefetcher
+	{
+	private:
+		struct Slot
+		{
+			unsigned int Sequence;
+			// One batch per shard of the batch, sliced the same way ParallelBackpropagation slices it
+			std::vector<Batch> Shards;
+			// Thrown by the loader while gathering, rethrown by Acquire
+			std::exception_ptr Error;
+		};
+
+		BatchView m_Data;
+		unsigned int m_BatchSize;
+		unsigned int m_ShardCount;
+		unsigned int m_InputSize;
+		unsigned int m_BatchCount;
+		unsigned int m_Capacity;
+		std::unique_ptr<Slot[]> m_Slots;
+		std::vector<std::thread> m_Loaders;
+		std::mutex m_Mutex;
+		std::condition_variable m_SlotFreed;
+		std::condition_variable m_BatchGathered;
+		unsigned int m_Epoch;
+		bool m_Finished;
+
+		void Load(unsigned int loader, unsigned int loaderCount);
+	public:
+		// capacity is rounded up to a multiple of loaderCount, so that every slot always belongs to the same loader
+		// Nothing is gathered before the first StartEpoch
+		BatchPrefetcher(const BatchView& data, unsigned int batchSize, unsigned int shardCount, unsigned int inputSize, unsigned int capacity, unsigned int loaderCount);
+		~BatchPrefetcher();
+		BatchPrefetcher(const BatchPrefetcher&) = delete;
+		BatchPrefetcher& operator=(const BatchPrefetcher&) = delete;
+
+		inline unsigned int GetBatchCount() const { return m_BatchCount; }
+		// Starts gathering the data in its current order, every batch of the previous epoch must have been acquired
+		void StartEpoch();
+		// Waits until batch is gathered, batches must be acquired in order
+		// Rethrows the exception the loader hit while gathering it
+		const std::vector<Batch>& Acquire(unsigned int batch);
+		// Hands the slot of batch back to its loader
+		void Release(unsigned int batch);
+	};
+}
@@ -0,0 +1,185 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "Dataset.h"
+#include <algorithm>
+#include <cstring>
+
+namespace nn
+{
+	Dataset::Dataset(unsigned int inputSize, unsigned int targetSize, unsigned int size)
+		: m_InputSize(inputSize), m_TargetSize(targetSize), m_Size(size), m_Inputs((size_t)size*inputSize, 0), m_Targets((size_t)size*targetSize, 0)
+	{
+	}
+
+	Dataset::Dataset(const std::vector<TrainingData>& data)
+		: m_InputSize(0), m_TargetSize(0), m_Size(0)
+	{
+		if (data.empty())
+			return;
+		const TrainingData& first = data.front();
+		m_InputSize = first.IsSparse() ? first.SparseInputs.GetWidth() : first.Inputs.size();
+		m_TargetSize = first.Target.size();
+		Resize(data.size());
+		for (unsigned int i = 0; i < m_Size; ++i)
+		{
+			const TrainingData& sample = data[i];
+			if ((sample.IsSparse() ? sample.SparseInputs.GetWidth() : sample.Inputs.size()) != m_InputSize || sample.Target.size() != m_TargetSize)
+				throw MatrixError("Sample does not match the data set!");
+			Scalar* inputs = GetInputs(i);
+			if (sample.IsSparse())
+				for (unsigned int k = sample.SparseInputs.GetRowOffsets()[0]; k < sample.SparseInputs.GetRowOffsets()[1]; ++k)
+					inputs[sample.SparseInputs.GetColumnIndices()[k]] = sample.SparseInputs.GetValues()[k];
+			else
+				std::copy(sample.Inputs.begin(), sample.Inputs.end(), inputs);
+			std::copy(sample.Target.begin(), sample.Target.end(), GetTarget(i));
+		}
+	}
+
+	void Dataset::Reserve(unsigned int size)
+	{
+		m_Inputs.reserve((size_t)size*m_InputSize);
+		m_Targets.reserve((size_t)size*m_TargetSize);
+	}
+
+	void Dataset::Resize(unsigned int size)
+	{
+		m_Inputs.resize((size_t)size*m_InputSize, 0);
+		m_Targets.resize((size_t)size*m_TargetSize, 0);
+		m_Size = size;
+	}
+
+	void Dataset::AddSample(const std::vector<Scalar>& inputs, const std::vector<Scalar>& target)
+	{
+		if (inputs.size() != m_InputSize || target.size() != m_TargetSize)
+			throw MatrixError("Sample does not match the data set!");
+		m_Inputs.insert(m_Inputs.end(), inputs.begin(), inputs.end());
+		m_Targets.insert(m_Targets.end(), target.begin(), target.end());
+		m_Size++;
+	}
+
+	void Dataset::AddSample(const std::vector<Scalar>& inputs, Scalar target)
+	{
+		if (inputs.size() != m_InputSize || m_TargetSize != 1)
+			throw MatrixError("Sample does not match the data set!");
+		m_Inputs.insert(m_Inputs.end(), inputs.begin(), inputs.end());
+		m_Targets.push_back(target);
+		m_Size++;
+	}
+
+	unsigned int BatchView::GetTargetSize() const
+	{
+		if (m_Dataset != nullptr)
+			return m_Dataset->GetTargetSize();
+		if (m_MappedDataset != nullptr)
+			return m_MappedDataset->GetTargetSize();
+		return (*m_Samples)[*m_Begin].Target.size();
+	}
+
+	bool BatchView::IsSparse() const
+	{
+		return m_Samples != nullptr && std::all_of(m_Begin, m_End, [this](unsigned int index) { return (*m_Samples)[index].IsSparse(); });
+	}
+
+	void BatchView::GatherInputs(Matrix& inputs) const
+	{
+		const unsigned int batchSize = GetSize();
+		Scalar* data = inputs.GetData();
+		const size_t stride = inputs.GetStride();
+		if (m_Dataset != nullptr)
+		{
+			// Every sample is one contiguous row, copied into a column of inputs
+			const unsigned int inputSize = m_Dataset->GetInputSize();
+			for (unsigned int c = 0; c < batchSize; ++c)
+			{
+				const Scalar* sample = m_Dataset->GetInputs(m_Begin[c]);
+				for (unsigned int i = 0; i < inputSize; ++i)
+					data[i*stride + c] = sample[i];
+			}
+			return;
+		}
+		if (m_MappedDataset != nullptr)
+		{
+			// The bytes are converted here, the data set itself is never decoded as a whole
+			for (unsigned int c = 0; c < batchSize; ++c)
+				m_MappedDataset->DecodeInputs(m_Begin[c], data + c, stride);
+			return;
+		}
+		for (unsigned int c = 0; c < batchSize; ++c)
+		{
+			const TrainingData& sample = (*m_Samples)[m_Begin[c]];
+			if (sample.IsSparse())
+				for (unsigned int k = sample.SparseInputs.GetRowOffsets()[0]; k < sample.SparseInputs.GetRowOffsets()[1]; ++k)
+					data[sample.SparseInputs.GetColumnIndices()[k] * stride + c] = sample.SparseInputs.GetValues()[k];
+			else
+				for (unsigned int i = 0; i < sample.Inputs.size(); ++i)
+					data[i*stride + c] = sample.Inputs[i];
+		}
+	}
+
+	void BatchView::GatherTargets(Matrix& targets) const
+	{
+		const unsigned int batchSize = GetSize();
+		Scalar* data = targets.GetData();
+		const size_t stride = targets.GetStride();
+		const unsigned int targetSize = GetTargetSize();
+		if (m_MappedDataset != nullptr)
+		{
+			// Labels were checked against the class count when the data set was loaded
+			for (unsigned int c = 0; c < batchSize; ++c)
+				data[m_MappedDataset->GetLabel(m_Begin[c])*stride + c] = 1;
+			return;
+		}
+		for (unsigned int c = 0; c < batchSize; ++c)
+		{
+			const Scalar* target = m_Dataset != nullptr ? m_Dataset->GetTarget(m_Begin[c]) : (*m_Samples)[m_Begin[c]].Target.data();
+			for (unsigned int i = 0; i < targetSize; ++i)
+				data[i*stride + c] = target[i];
+		}
+	}
+
+	void BatchView::GatherSparseInputs(SparseMatrix& inputs) const
+	{
+		std::for_each(m_Begin, m_End, [this, &inputs](unsigned int index) { inputs.AppendRows((*m_Samples)[index].SparseInputs); });
+	}
+
+	void BatchView::Gather(Batch& batch, unsigned int inputSize) const
+	{
+		const unsigned int batchSize = GetSize();
+		const unsigned int targetSize = GetTargetSize();
+		batch.Sparse = IsSparse();
+		if (batch.Targets.GetHeight() == targetSize && batch.Targets.GetWidth() == batchSize)
+			batch.Targets.ZeroOut();
+		else
+			batch.Targets = Matrix(targetSize, batchSize, 0);
+		GatherTargets(batch.Targets);
+		if (batch.Sparse)
+		{
+			batch.SparseInputs.Clear();
+			GatherSparseInputs(batch.SparseInputs);
+			return;
+		}
+		if (batch.Inputs.GetHeight() == inputSize && batch.Inputs.GetWidth() == batchSize)
+			batch.Inputs.ZeroOut();
+		else
+			batch.Inputs = Matrix(inputSize, batchSize, 0);
+		GatherInputs(batch.Inputs);
+	}
+}
@@ -0,0 +1,139 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+#include <vector>
+#include "../math/Matrix.h"
+#include "../math/SparseMatrix.h"
+#include "MappedDataset.h"
+
+namespace nn
+{
+	struct TrainingData
+	{
+		std::vector<Scalar> Inputs;
+		std::vector<Scalar> Target;
+		// Used instead of Inputs when the sample was built from a 1 x inputSize sparse row
+		SparseMatrix SparseInputs;
+		TrainingData(const std::vector<Scalar>& inputs, Scalar target) : Inputs(inputs), Target({ target }) {}
+		TrainingData(const std::vector<Scalar>& inputs, const std::vector<Scalar>& target) : Inputs(inputs), Target(target) {}
+		TrainingData(const SparseMatrix& inputs, Scalar target) : Target({ target }), SparseInputs(inputs) {}
+		TrainingData(const SparseMatrix& inputs, const std::vector<Scalar>& target) : Target(target), SparseInputs(inputs) {}
+		TrainingData& operator=(const TrainingData& data)
+		{
+			Inputs = data.Inputs;
+			Target = data.Target;
+			SparseInputs = data.SparseInputs;
+			return *this;
+		}
+		TrainingData& operator=(TrainingData&& data) noexcept
+		{
+			Inputs = std::move(data.Inputs);
+			Target = std::move(data.Target);
+			SparseInputs = std::move(data.SparseInputs);
+			return *this;
+		}
+		TrainingData(const TrainingData& data) : Inputs(data.Inputs), Target(data.Target), SparseInputs(data.SparseInputs) {}
+		TrainingData(TrainingData&& data) noexcept : Inputs(std::move(data.Inputs)), Target(std::move(data.Target)), SparseInputs(std::move(data.SparseInputs)) {}
+		TrainingData(std::vector<Scalar>&& inputs, std::vector<Scalar>&& target) noexcept : Inputs(std::move(inputs)), Target(std::move(target)) {}
+		inline bool IsSparse() const { return SparseInputs.GetWidth() != 0; }
+	};
+
+	// Dense samples stored in two contiguous row-major buffers, one row of inputs and one row of targets per sample
+	class Dataset
+	{
+	private:
+		unsigned int m_InputSize;
+		unsigned int m_TargetSize;
+		unsigned int m_Size;
+		std::vector<Scalar> m_Inputs;
+		std::vector<Scalar> m_Targets;
+	public:
+		explicit Dataset(unsigned int inputSize, unsigned int targetSize, unsigned int size = 0);
+		// Sparse samples are stored densely, throws MatrixError when a sample does not match the sizes of the first one
+		explicit Dataset(const std::vector<TrainingData>& data);
+
+		inline unsigned int GetSize() const { return m_Size; }
+		inline unsigned int GetInputSize() const { return m_InputSize; }
+		inline unsigned int GetTargetSize() const { return m_TargetSize; }
+		inline const Scalar* GetInputs(unsigned int sample) const { return m_Inputs.data() + (size_t)sample*m_InputSize; }
+		inline Scalar* GetInputs(unsigned int sample) { return m_Inputs.data() + (size_t)sample*m_InputSize; }
+		inline const Scalar* GetTarget(unsigned int sample) const { return m_Targets.data() + (size_t)sample*m_TargetSize; }
+		inline Scalar* GetTarget(unsigned int sample) { return m_Targets.data() + (size_t)sample*m_TargetSize; }
+		// Inputs of one sample as a column vector, for Eval
+		inline MatrixView GetInputView(unsigned int sample) const { return MatrixView(GetInputs(sample), m_InputSize, 1, 1); }
+
+		void Reserve(unsigned int size);
+		// New samples are zero
+		void Resize(unsigned int size);
+		// Throws MatrixError when the sizes of the sample differ from those of the data set
+		void AddSample(const std::vector<Scalar>& inputs, const std::vector<Scalar>& target);
+		void AddSample(const std::vector<Scalar>& inputs, Scalar target);
+	};
+
+	// A batch in the layout the network consumes, sample i of the batch is column i of Inputs and Targets
+	struct Batch
+	{
+		Matrix Inputs;
+		Matrix Targets;
+		// Used instead of Inputs when every sample is sparse, sample i is row i
+		SparseMatrix SparseInputs;
+		bool Sparse = false;
+	};
+
+	// Samples of a data set picked by a range of indices, a batch is passed around without copying the samples
+	class BatchView
+	{
+	private:
+		// Exactly one of them is set
+		const std::vector<TrainingData>* m_Samples;
+		const Dataset* m_Dataset;
+		const MappedDataset* m_MappedDataset;
+		std::vector<unsigned int>::const_iterator m_Begin;
+		std::vector<unsigned int>::const_iterator m_End;
+	public:
+		BatchView(const std::vector<TrainingData>& samples, std::vector<unsigned int>::const_iterator begin, std::vector<unsigned int>::const_iterator end)
+			: m_Samples(&samples), m_Dataset(nullptr), m_MappedDataset(nullptr), m_Begin(begin), m_End(end) {}
+		BatchView(const Dataset& dataset, std::vector<unsigned int>::const_iterator begin, std::vector<unsigned int>::const_iterator end)
+			: m_Samples(nullptr), m_Dataset(&dataset), m_MappedDataset(nullptr), m_Begin(begin), m_End(end) {}
+		BatchView(const MappedDataset& dataset, std::vector<unsigned int>::const_iterator begin, std::vector<unsigned int>::const_iterator end)
+			: m_Samples(nullptr), m_Dataset(nullptr), m_MappedDataset(&dataset), m_Begin(begin), m_End(end) {}
+
+		inline unsigned int GetSize() const { return (unsigned int)(m_End - m_Begin); }
+		inline BatchView Slice(unsigned int begin, unsigned int end) const
+		{
+			BatchView slice = *this;
+			slice.m_Begin = m_Begin + begin;
+			slice.m_End = m_Begin + end;
+			return slice;
+		}
+		unsigned int GetTargetSize() const;
+		// True when every sample of the batch is sparse
+		bool IsSparse() const;
+		// Sample i of the batch goes to column i, inputs and targets must be zero and have GetSize() columns
+		void GatherInputs(Matrix& inputs) const;
+		void GatherTargets(Matrix& targets) const;
+		// Sample i of the batch goes to row i, only for sparse batches
+		void GatherSparseInputs(SparseMatrix& inputs) const;
+		// Fills batch with inputSize inputs per sample, its matrices are reused when they already have the right shape
+		// and its sparse inputs keep their storage
+		void Gather(Batch& batch, unsigned int inputSize) const;
+	};
+}
@@ -0,0 +1,158 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "MappedDataset.h"
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace nn
+{
+	namespace
+	{
+		// IDX header: two zero bytes, the element type, the number of dimensions and then every dimension as a big-endian 32-bit integer
+		static const unsigned char IDX_UNSIGNED_BYTE = 0x08;
+
+		unsigned int ReadBigEndian(const unsigned char* bytes)
+		{
+			return ((unsigned int)bytes[0] << 24) | ((unsigned int)bytes[1] << 16) | ((unsigned int)bytes[2] << 8) | bytes[3];
+		}
+
+		// Returns the header size, dimensions receives the sizes of all dimensions
+		size_t ReadIdxHeader(const MappedFile& file, const char* fileName, std::vector<unsigned int>& dimensions)
+		{
+			const unsigned char* data = file.GetData();
+			if (file.GetSize() < 4 || data[0] != 0 || data[1] != 0 || data[2] != IDX_UNSIGNED_BYTE || data[3] == 0)
+				throw std::runtime_error(std::string("Not an unsigned byte IDX file: ") + fileName);
+			const size_t headerSize = 4 + 4 * (size_t)data[3];
+			if (file.GetSize() < headerSize)
+				throw std::runtime_error(std::string("Truncated IDX file: ") + fileName);
+			for (unsigned int i = 0; i < data[3]; ++i)
+				dimensions.push_back(ReadBigEndian(data + 4 + 4 * i));
+			return headerSize;
+		}
+	}
+
+	MappedFile::MappedFile(const char* fileName)
+		: m_Data(nullptr), m_Size(0)
+	{
+#ifdef _WIN32
+		m_Mapping = nullptr;
+		HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			throw std::runtime_error(std::string("Cannot open file: ") + fileName);
+		LARGE_INTEGER size;
+		GetFileSizeEx(file, &size);
+		m_Size = (size_t)size.QuadPart;
+		if (m_Size > 0)
+		{
+			m_Mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			m_Data = m_Mapping != nullptr ? (const unsigned char*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		}
+		CloseHandle(file);
+#else
+		int file = open(fileName, O_RDONLY);
+		if (file < 0)
+			throw std::runtime_error(std::string("Cannot open file: ") + fileName);
+		struct stat status;
+		fstat(file, &status);
+		m_Size = (size_t)status.st_size;
+		if (m_Size > 0)
+		{
+			void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, file, 0);
+			m_Data = data != MAP_FAILED ? (const unsigned char*)data : nullptr;
+		}
+		close(file);
+#endif // _WIN32
+		if (m_Size > 0 && m_Data == nullptr)
+			throw std::runtime_error(std::string("Cannot map file: ") + fileName);
+	}
+
+	MappedFile::~MappedFile()
+	{
+#ifdef _WIN32
+		if (m_Data != nullptr)
+			UnmapViewOfFile(m_Data);
+		if (m_Mapping != nullptr)
+			CloseHandle(m_Mapping);
+#else
+		if (m_Data != nullptr)
+			munmap((void*)m_Data, m_Size);
+#endif // _WIN32
+	}
+
+	MappedDataset::MappedDataset(std::shared_ptr<MappedFile> inputsFile, size_t inputsOffset, std::shared_ptr<MappedFile> labelsFile, size_t labelsOffset,
+		unsigned int size, unsigned int inputSize, unsigned int classCount, Scalar scale)
+		: m_InputsFile(inputsFile), m_LabelsFile(labelsFile), m_Inputs(inputsFile->GetData() + inputsOffset), m_Labels(labelsFile->GetData() + labelsOffset),
+		m_Size(size), m_InputSize(inputSize), m_ClassCount(classCount), m_Scale(scale)
+	{
+		if (inputsFile->GetSize() < inputsOffset + (size_t)size*inputSize || labelsFile->GetSize() < labelsOffset + size)
+			throw std::runtime_error("Data set files are shorter than their sample count!");
+		// Checked once here, so that gathering a batch, possibly on a loader thread, never meets a bad label
+		for (unsigned int i = 0; i < size; ++i)
+			if (m_Labels[i] >= classCount)
+				throw std::runtime_error("Label exceeds the class count of the data set!");
+	}
+
+	MappedDataset MappedDataset::LoadIdx(const char* inputsFile, const char* labelsFile, unsigned int classCount, Scalar scale)
+	{
+		std::shared_ptr<MappedFile> inputs = std::make_shared<MappedFile>(inputsFile);
+		std::shared_ptr<MappedFile> labels = std::make_shared<MappedFile>(labelsFile);
+		std::vector<unsigned int> inputDimensions, labelDimensions;
+		const size_t inputsOffset = ReadIdxHeader(*inputs, inputsFile, inputDimensions);
+		const size_t labelsOffset = ReadIdxHeader(*labels, labelsFile, labelDimensions);
+		if (inputDimensions.empty() || labelDimensions.size() != 1 || labelDimensions[0] != inputDimensions[0])
+			throw std::runtime_error("IDX label file does not hold one label per sample!");
+		// Every dimension but the first makes up one sample
+		size_t inputSize = 1;
+		for (unsigned int i = 1; i < inputDimensions.size(); ++i)
+		{
+			if (inputDimensions[i] != 0 && inputSize > std::numeric_limits<unsigned int>::max() / inputDimensions[i])
+				throw std::runtime_error(std::string("IDX sample size is too large: ") + inputsFile);
+			inputSize *= inputDimensions[i];
+		}
+		return MappedDataset(inputs, inputsOffset, labels, labelsOffset, inputDimensions[0], (unsigned int)inputSize, classCount, scale);
+	}
+
+	MappedDataset MappedDataset::LoadRaw(const char* inputsFile, unsigned int inputSize, const char* labelsFile, unsigned int classCount, Scalar scale)
+	{
+		std::shared_ptr<MappedFile> inputs = std::make_shared<MappedFile>(inputsFile);
+		std::shared_ptr<MappedFile> labels = std::make_shared<MappedFile>(labelsFile);
+		if (labels->GetSize() > std::numeric_limits<unsigned int>::max())
+			throw std::runtime_error(std::string("Too many labels in file: ") + labelsFile);
+		return MappedDataset(inputs, 0, labels, 0, (unsigned int)labels->GetSize(), inputSize, classCount, scale);
+	}
+
+	void MappedDataset::DecodeInputs(unsigned int sample, Scalar* inputs, size_t stride) const
+	{
+		const unsigned char* bytes = GetInputs(sample);
+		for (unsigned int i = 0; i < m_InputSize; ++i)
+			inputs[i*stride] = bytes[i] * m_Scale;
+	}
+}
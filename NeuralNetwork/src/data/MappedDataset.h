@@ -0,0 +1,78 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+#include <memory>
+#include "../math/Scalar.h"
+
+namespace nn
+{
+	// Read-only mapping of a whole file, the OS reads its pages on first access and may drop them again under memory pressure
+	class MappedFile
+	{
+	private:
+		const unsigned char* m_Data;
+		size_t m_Size;
+#ifdef _WIN32
+		void* m_Mapping;
+#endif // _WIN32
+	public:
+		explicit MappedFile(const char* fileName);
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		inline const unsigned char* GetData() const { return m_Data; }
+		inline size_t GetSize() const { return m_Size; }
+	};
+
+	// Samples of unsigned bytes with one class label each, read from mapped files and converted a batch at a time
+	// Nothing is parsed up front, so data sets larger than memory can be trained on
+	class MappedDataset
+	{
+	private:
+		std::shared_ptr<MappedFile> m_InputsFile;
+		std::shared_ptr<MappedFile> m_LabelsFile;
+		const unsigned char* m_Inputs;
+		const unsigned char* m_Labels;
+		unsigned int m_Size;
+		unsigned int m_InputSize;
+		unsigned int m_ClassCount;
+		Scalar m_Scale;
+
+		MappedDataset(std::shared_ptr<MappedFile> inputsFile, size_t inputsOffset, std::shared_ptr<MappedFile> labelsFile, size_t labelsOffset,
+			unsigned int size, unsigned int inputSize, unsigned int classCount, Scalar scale);
+	public:
+		// Both throw std::runtime_error when the files are malformed or a label is not below classCount
+		// IDX files such as MNIST's, inputs of any shape and one label per sample, both of type unsigned byte
+		static MappedDataset LoadIdx(const char* inputsFile, const char* labelsFile, unsigned int classCount, Scalar scale = (Scalar)1 / 255);
+		// Headerless files, inputSize bytes per sample and one label byte per sample
+		static MappedDataset LoadRaw(const char* inputsFile, unsigned int inputSize, const char* labelsFile, unsigned int classCount, Scalar scale = (Scalar)1 / 255);
+
+		inline unsigned int GetSize() const { return m_Size; }
+		inline unsigned int GetInputSize() const { return m_InputSize; }
+		// Targets are one-hot vectors of the labels
+		inline unsigned int GetTargetSize() const { return m_ClassCount; }
+		inline const unsigned char* GetInputs(unsigned int sample) const { return m_Inputs + (size_t)sample*m_InputSize; }
+		inline unsigned int GetLabel(unsigned int sample) const { return m_Labels[sample]; }
+		// Writes the scaled inputs of sample to inputs[0], inputs[stride], ...
+		void DecodeInputs(unsigned int sample, Scalar* inputs, size_t stride) const;
+	};
+}
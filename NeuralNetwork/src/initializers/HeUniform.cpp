@@ -28,9 +28,9 @@ namespace nn
 		{
 			std::random_device randomDevice;
 			std::mt19937 engine(randomDevice());
-			std::uniform_real_distribution<double> valueDistribution(0.0, 1.0);
-			double factor = 2.0 * sqrt(6.0 / matrix.GetWidth());
-			matrix.Map([factor, &valueDistribution, &engine](double x)
+			std::uniform_real_distribution<Scalar> valueDistribution(0.0, 1.0);
+			Scalar factor = 2.0 * sqrt(6.0 / matrix.GetWidth());
+			matrix.Map([factor, &valueDistribution, &engine](Scalar x)
 			{
 				return (valueDistribution(engine) - 0.5) * factor;
 			});
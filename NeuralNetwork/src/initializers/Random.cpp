@@ -28,8 +28,8 @@ namespace nn
 		{
 			std::random_device randomDevice;
 			std::mt19937 engine(randomDevice());
-			std::uniform_real_distribution<double> valueDistribution(m_Min, m_Max);
-			matrix.Map([&valueDistribution, &engine](double x)
+			std::uniform_real_distribution<Scalar> valueDistribution(m_Min, m_Max);
+			matrix.Map([&valueDistribution, &engine](Scalar x)
 			{
 				return valueDistribution(engine);
 			});
@@ -41,8 +41,8 @@ namespace nn
 		class Random : public Initializer
 		{
 		private:
-			double m_Min = -1;
-			double m_Max = 1;
+			Scalar m_Min = -1;
+			Scalar m_Max = 1;
 		public:
 			void Initialize(Matrix& matrix) const override;
 		};
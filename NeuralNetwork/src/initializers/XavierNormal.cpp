@@ -27,9 +27,9 @@ namespace nn
 		void XavierNormal::Initialize(Matrix& matrix) const
 		{
 			std::default_random_engine engine;
-			std::normal_distribution<double> valueDistribution(0.0, 1.0);
-			double factor = 2.0 * sqrt(6.0 / (matrix.GetWidth() + matrix.GetHeight()));
-			matrix.Map([factor, &valueDistribution, &engine](double x)
+			std::normal_distribution<Scalar> valueDistribution(0.0, 1.0);
+			Scalar factor = 2.0 * sqrt(6.0 / (matrix.GetWidth() + matrix.GetHeight()));
+			matrix.Map([factor, &valueDistribution, &engine](Scalar x)
 			{
 				return valueDistribution(engine) * factor;
 			});
@@ -22,16 +22,73 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>
 
 namespace nn
 {
-	Matrix Layer::UpdateActivation(const Matrix & input)
+	const Matrix& Layer::UpdateActivation(const MatrixView & input)
 	{
-		WeightedSum = WeightMatrix*input + BiasMatrix;
+		ComputeWeightedSum(input, WeightedSum);
 		Activation = WeightedSum;
 		Activation = ActivationFunction->Function(Activation);
 		return Activation;
 	}
 
+	const Matrix& Layer::UpdateActivation(const SparseMatrix & input)
+	{
+		ComputeWeightedSum(input, WeightedSum);
+		Activation = WeightedSum;
+		Activation = ActivationFunction->Function(Activation);
+		return Activation;
+	}
+
+	const Matrix& Layer::UpdateActivation(const MatrixView & input, LayerState & state) const
+	{
+		ComputeWeightedSum(input, state.WeightedSum);
+		state.Activation = state.WeightedSum;
+		// Copied rather than moved, so the state keeps the storage of the thread that first ran it
+		const Matrix& activation = state.ActivationFunction->Function(state.Activation);
+		state.Activation = activation;
+		return state.Activation;
+	}
+
+	const Matrix& Layer::UpdateActivation(const SparseMatrix & input, LayerState & state) const
+	{
+		ComputeWeightedSum(input, state.WeightedSum);
+		state.Activation = state.WeightedSum;
+		// Copied rather than moved, so the state keeps the storage of the thread that first ran it
+		const Matrix& activation = state.ActivationFunction->Function(state.Activation);
+		state.Activation = activation;
+		return state.Activation;
+	}
+
+	LayerState Layer::CreateState() const
+	{
+		// Activation functions keep their last result for the derivative, so every state needs its own
+		return{ Matrix(), Matrix(), ActivationFunctionFactory::BuildActivationFunction(ActivationFunction->GetType()) };
+	}
+
+	void Layer::ComputeWeightedSum(const MatrixView & input, Matrix & weightedSum) const
+	{
+		if (IsCompressed())
+			weightedSum = CompressedWeights*input;
+		else if (IsQuantized())
+			weightedSum = QuantizedWeights*input;
+		else
+			weightedSum.AssignProduct(WeightMatrix, input);
+		weightedSum.AddToColumns(BiasMatrix);
+	}
+
+	void Layer::ComputeWeightedSum(const SparseMatrix & input, Matrix & weightedSum) const
+	{
+		// Compressed and quantized weights have no sparse kernel, they are widened for the call
+		if (IsCompressed())
+			weightedSum = Matrix::MultiplyTranspose(CompressedWeights.ToMatrix(), input);
+		else if (IsQuantized())
+			weightedSum = Matrix::MultiplyTranspose(QuantizedWeights.Dequantize(), input);
+		else
+			weightedSum = Matrix::MultiplyTranspose(WeightMatrix, input);
+		weightedSum.AddToColumns(BiasMatrix);
+	}
+
 	Layer::Layer(unsigned int inputNeurons, unsigned int outputNeurons, nn::activation::Type activationFunction)
-		: WeightMatrix(outputNeurons, inputNeurons),
+		: WeightMatrix(outputNeurons, inputNeurons, -1, Matrix::PaddedStride(inputNeurons)),
 		BiasMatrix(outputNeurons, 1),
 		Activation(outputNeurons, 1),
 		ActivationFunction(ActivationFunctionFactory::BuildActivationFunction(activationFunction)),
@@ -40,14 +97,26 @@ namespace nn
 
 	}
 
+	Layer::Layer(Matrix && weightMatrix, Matrix && biasMatrix, activation::Type activationFunction)
+		: WeightMatrix(std::move(weightMatrix)),
+		BiasMatrix(std::move(biasMatrix)),
+		Activation(BiasMatrix.GetHeight(), 1, 0),
+		ActivationFunction(ActivationFunctionFactory::BuildActivationFunction(activationFunction)),
+		WeightedSum(BiasMatrix.GetHeight(), 1, 0)
+	{
+
+	}
+
 	Layer::Layer(Layer && layer) noexcept : WeightMatrix(std::move(layer.WeightMatrix)), BiasMatrix(std::move(layer.BiasMatrix)),
-		Activation(std::move(layer.Activation)), WeightedSum(std::move(layer.WeightedSum)), ActivationFunction(std::move(layer.ActivationFunction))
+		Activation(std::move(layer.Activation)), WeightedSum(std::move(layer.WeightedSum)), ActivationFunction(std::move(layer.ActivationFunction)),
+		CompressedWeights(std::move(layer.CompressedWeights)), QuantizedWeights(std::move(layer.QuantizedWeights))
 	{
 
 	}
 
 	Layer::Layer(const Layer & layer) : WeightMatrix(layer.WeightMatrix), BiasMatrix(layer.BiasMatrix),
-		Activation(layer.Activation), WeightedSum(layer.WeightedSum), ActivationFunction(layer.ActivationFunction)
+		Activation(layer.Activation), WeightedSum(layer.WeightedSum), ActivationFunction(layer.ActivationFunction),
+		CompressedWeights(layer.CompressedWeights), QuantizedWeights(layer.QuantizedWeights)
 	{
 	}
 
@@ -56,25 +125,70 @@ namespace nn
 		initializer->Initialize(WeightMatrix);
 	}
 
+	void Layer::Compress(math::StorageFormat format)
+	{
+		Decompress();
+		CompressedWeights = HalfMatrix(WeightMatrix, format);
+		WeightMatrix = Matrix();
+		BiasMatrix = HalfMatrix(BiasMatrix, format).ToMatrix();
+	}
+
+	void Layer::Quantize()
+	{
+		Decompress();
+		QuantizedWeights = QuantizedMatrix(WeightMatrix);
+		WeightMatrix = Matrix();
+	}
+
+	void Layer::Decompress()
+	{
+		if (IsQuantized())
+		{
+			WeightMatrix = QuantizedWeights.Dequantize();
+			QuantizedWeights = QuantizedMatrix();
+		}
+		if (!IsCompressed())
+			return;
+		WeightMatrix = CompressedWeights.ToMatrix();
+		CompressedWeights = HalfMatrix();
+	}
+
 	void Layer::SaveLayer(std::ofstream & outfile) const
 	{
-		WeightMatrix.SaveMatrix(outfile);
-		BiasMatrix.SaveMatrix(outfile);
+		if (IsCompressed())
+		{
+			CompressedWeights.SaveMatrix(outfile);
+			HalfMatrix(BiasMatrix, CompressedWeights.GetFormat()).SaveMatrix(outfile);
+		}
+		else
+		{
+			if (IsQuantized())
+				QuantizedWeights.Dequantize().SaveMatrix(outfile);
+			else
+				WeightMatrix.SaveMatrix(outfile);
+			BiasMatrix.SaveMatrix(outfile);
+		}
 		ActivationFunction->SaveActivationFunction(outfile);
 	}
 
-	Layer Layer::LoadLayer(std::ifstream & infile)
+	Layer Layer::LoadLayer(std::ifstream & infile, unsigned int storedScalarSize, math::StorageFormat format)
 	{
-		Matrix weightMatrix = Matrix::LoadMatrix(infile);
-		Matrix biasMatrix = Matrix::LoadMatrix(infile);
 		int activationType;
+		if (storedScalarSize == sizeof(uint16_t))
+		{
+			HalfMatrix weightMatrix = HalfMatrix::LoadMatrix(infile, format);
+			HalfMatrix biasMatrix = HalfMatrix::LoadMatrix(infile, format);
+			infile.read((char*)&activationType, sizeof(activationType));
+			Layer layer(Matrix(), biasMatrix.ToMatrix(), activation::Type(activationType));
+			layer.CompressedWeights = std::move(weightMatrix);
+			return layer;
+		}
+		Matrix weightMatrix = Matrix::LoadMatrix(infile, storedScalarSize);
+		Matrix biasMatrix = Matrix::LoadMatrix(infile, storedScalarSize);
 		infile.read((char*)&activationType, sizeof(activationType));
-		activation::Type type = activation::Type(activationType);
-		Layer layer(weightMatrix.GetWidth(), weightMatrix.GetHeight(), type);
-		layer.WeightMatrix = std::move(weightMatrix);
-		layer.BiasMatrix = std::move(biasMatrix);
-		return layer;
+		return Layer(std::move(weightMatrix), std::move(biasMatrix), activation::Type(activationType));
 	}
+
 	Layer & Layer::operator=(Layer && layer)
 	{
 		WeightMatrix = std::move(layer.WeightMatrix);
@@ -82,6 +196,8 @@ namespace nn
 		Activation = std::move(layer.Activation);
 		ActivationFunction = std::move(layer.ActivationFunction);
 		WeightedSum = std::move(layer.WeightedSum);
+		CompressedWeights = std::move(layer.CompressedWeights);
+		QuantizedWeights = std::move(layer.QuantizedWeights);
 		return *this;
 	}
 
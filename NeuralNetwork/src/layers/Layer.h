@@ -20,11 +20,22 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>
 
 #pragma once
 #include "../math/Matrix.h"
+#include "../math/SparseMatrix.h"
+#include "../math/HalfMatrix.h"
+#include "../math/QuantizedMatrix.h"
 #include "../activations/ActivationFunctions.h"
 #include "../initializers/WeightInitializers.h"
 
 namespace nn
 {
+	// Forward state of a layer for one thread, so that several threads can run the same weights on different samples
+	struct LayerState
+	{
+		Matrix Activation;
+		Matrix WeightedSum;
+		std::shared_ptr<activation::ActivationFunction> ActivationFunction;
+	};
+
 	class Layer
 	{
 	public:
@@ -33,15 +44,41 @@ namespace nn
 		std::shared_ptr<activation::ActivationFunction> ActivationFunction;
 		Matrix Activation;
 		Matrix WeightedSum;
+		// Holds the weights instead of WeightMatrix while the layer is compressed
+		HalfMatrix CompressedWeights;
+		// Holds the weights instead of WeightMatrix while the layer is quantized
+		QuantizedMatrix QuantizedWeights;
 	public:
 		Layer(unsigned int inputNeurons, unsigned int outputNeurons, activation::Type activationFunction);
 		void Initialize(const std::shared_ptr<initialization::Initializer> initializer);
-		Matrix UpdateActivation(const Matrix& input);
+		// Every column of input is one sample, the activations get one column per sample
+		const Matrix& UpdateActivation(const MatrixView& input);
+		// Sparse batchSize x inputNeurons input, costs one multiply-add per nonzero and output neuron
+		const Matrix& UpdateActivation(const SparseMatrix& input);
+		// Same as above with the results written to state instead of the layer, the layer is only read
+		const Matrix& UpdateActivation(const MatrixView& input, LayerState& state) const;
+		const Matrix& UpdateActivation(const SparseMatrix& input, LayerState& state) const;
+		LayerState CreateState() const;
+		// Moves the weights to 16-bit storage and rounds the bias to the same format, for inference only
+		void Compress(math::StorageFormat format);
+		// Moves the weights to int8 storage with a scale and zero point per row, for inference only, the bias keeps full precision
+		void Quantize();
+		// Widens compressed or quantized weights back to Scalar, training needs full precision
+		void Decompress();
+		inline bool IsCompressed() const { return !CompressedWeights.IsEmpty(); }
+		inline bool IsQuantized() const { return QuantizedWeights.GetHeight() != 0; }
+		// Quantized weights are saved dequantized
 		void SaveLayer(std::ofstream& outfile) const;
-		static Layer LoadLayer(std::ifstream& infile);
+		// A storedScalarSize of 2 loads a compressed layer saved in the given format
+		static Layer LoadLayer(std::ifstream& infile, unsigned int storedScalarSize = sizeof(Scalar), math::StorageFormat format = math::FLOAT16);
 		Layer& operator=(Layer&& layer);
 		Layer(Layer&& layer) noexcept;
 		Layer(const Layer& layer);
+	private:
+		void ComputeWeightedSum(const MatrixView& input, Matrix& weightedSum) const;
+		void ComputeWeightedSum(const SparseMatrix& input, Matrix& weightedSum) const;
+		// Takes loaded parameters as they are, without initializing a second set of weights
+		Layer(Matrix&& weightMatrix, Matrix&& biasMatrix, activation::Type activationFunction);
 	};
 }
 
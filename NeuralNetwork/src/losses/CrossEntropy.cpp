@@ -26,14 +26,23 @@ namespace nn
 	{
 		double CrossEntropy::GetLoss(const Matrix& prediction, const Matrix& target) const
 		{
-			std::vector<double> predictionVector = prediction.GetColumnVector();
-			std::vector<double> targetVector = target.GetColumnVector();
+			Matrix logPrediction = prediction;
+			Matrix logComplement = 1 - prediction;
+			logPrediction.Log();
+			logComplement.Log();
+			// Rows are walked separately, each matrix may have its own padding
 			double sum = 0.0;
-			std::vector<double>::iterator tIt = targetVector.begin();
-			for (std::vector<double>::iterator pIt = predictionVector.begin(); pIt != predictionVector.end(); ++pIt, ++tIt)
+			for (unsigned int i = 0; i < prediction.GetHeight(); ++i)
 			{
-				double value = -*tIt*log(*pIt) - (1 - *tIt)*log(1 - *pIt);
-				if (!isnan(value)) sum += value;
+				const Scalar* pIt = logPrediction.GetData() + (size_t)i*logPrediction.GetStride();
+				const Scalar* cIt = logComplement.GetData() + (size_t)i*logComplement.GetStride();
+				const Scalar* tIt = target.GetData() + (size_t)i*target.GetStride();
+				const Scalar* pEnd = pIt + prediction.GetWidth();
+				for (; pIt != pEnd; ++pIt, ++cIt, ++tIt)
+				{
+					Scalar value = -(*tIt)*(*pIt) - (1 - *tIt)*(*cIt);
+					if (!isnan(value)) sum += value;
+				}
 			}
 			return sum;
 		}
@@ -24,15 +24,15 @@ namespace nn
 {
 	namespace loss
 	{
-		Matrix LossFunction::Backward(Layer & layer, Matrix & error)
+		Matrix LossFunction::Backward(LayerState & state, Matrix & error)
 		{
-			Matrix gradient = layer.ActivationFunction->Derivative(layer.WeightedSum);
+			Matrix gradient = state.ActivationFunction->Derivative(state.WeightedSum);
 			gradient.DotProduct(error);
 			return gradient;
 		}
-		void LossFunction::PropagateError(Layer & layer, Matrix & error) const
+		void LossFunction::PropagateError(const Layer & layer, Matrix & error) const
 		{
-			error = Matrix::Transpose(layer.WeightMatrix) * error;
+			error = Matrix::TransposeMultiply(layer.WeightMatrix, error);
 		}
 	}
 
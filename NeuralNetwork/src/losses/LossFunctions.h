@@ -37,8 +37,8 @@ namespace nn
 			virtual double GetLoss(const Matrix& prediction, const Matrix& target) const = 0;
 			virtual Matrix GetDerivative(const Matrix& prediction, const Matrix& target) const = 0;
 			virtual Type GetType() const = 0;
-			Matrix Backward(Layer& layer, Matrix& error);
-			void PropagateError(Layer& layer, Matrix& error) const;
+			Matrix Backward(LayerState& state, Matrix& error);
+			void PropagateError(const Layer& layer, Matrix& error) const;
 		};
 
 		class MeanAbsoluteError : public LossFunction
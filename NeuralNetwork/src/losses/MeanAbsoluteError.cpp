@@ -26,12 +26,12 @@ namespace nn
 	{
 		double MeanAbsoluteError::GetLoss(const Matrix& prediction, const Matrix& target) const
 		{
-			return Matrix::Map(prediction - target, [](double x) { return abs(x); }).Sum();
+			return Matrix::Map(prediction - target, [](Scalar x) { return abs(x); }).Sum();
 		}
 
 		Matrix MeanAbsoluteError::GetDerivative(const Matrix& prediction, const Matrix& target) const
 		{
-			return Matrix::Map(prediction - target, [](double x) { return x >= 0 ? 1 : -1; });
+			return Matrix::Map(prediction - target, [](Scalar x) { return x >= 0 ? 1 : -1; });
 		}
 
 		Type MeanAbsoluteError::GetType() const
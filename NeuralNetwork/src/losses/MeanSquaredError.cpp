@@ -26,12 +26,13 @@ namespace nn
 	{
 		double MeanSquaredError::GetLoss(const Matrix& prediction, const Matrix& target) const
 		{
-			return Matrix::Map(prediction - target, [](double x) { return x*x; }).Sum() / (target.GetWidth() * target.GetHeight());
+			// The mean is taken over the outputs of each sample, a batch sums the means of its columns
+			return Matrix::Map(prediction - target, [](Scalar x) { return x*x; }).Sum() / target.GetHeight();
 		}
 
 		Matrix MeanSquaredError::GetDerivative(const Matrix& prediction, const Matrix& target) const
 		{
-			return (prediction - target) * (2.0 / (target.GetWidth() * target.GetHeight()));
+			return (prediction - target) * (2.0 / target.GetHeight());
 		}
 
 		Type MeanSquaredError::GetType() const
@@ -26,7 +26,7 @@ namespace nn
 	{
 		double Quadratic::GetLoss(const Matrix& prediction, const Matrix& target) const
 		{
-			return Matrix::Map(prediction - target, [](double x) { return x*x; }).Sum();
+			return Matrix::Map(prediction - target, [](Scalar x) { return x*x; }).Sum();
 		}
 
 		Matrix Quadratic::GetDerivative(const Matrix& prediction, const Matrix& target) const
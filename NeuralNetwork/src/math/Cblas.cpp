@@ -0,0 +1,83 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "Cblas.h"
+
+#ifdef NN_USE_CBLAS
+#include <cblas.h>
+
+namespace math
+{
+	namespace cblas
+	{
+		namespace
+		{
+			inline CBLAS_TRANSPOSE ToCblas(Operation operation)
+			{
+				return operation == TRANSPOSE ? CblasTrans : CblasNoTrans;
+			}
+		}
+
+		void Gemm(Operation transA, Operation transB, unsigned int m, unsigned int n, unsigned int k, double alpha, const double* a, unsigned int lda,
+			const double* b, unsigned int ldb, double beta, double* c, unsigned int ldc)
+		{
+			cblas_dgemm(CblasRowMajor, ToCblas(transA), ToCblas(transB), m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+		}
+
+		void Gemm(Operation transA, Operation transB, unsigned int m, unsigned int n, unsigned int k, float alpha, const float* a, unsigned int lda,
+			const float* b, unsigned int ldb, float beta, float* c, unsigned int ldc)
+		{
+			cblas_sgemm(CblasRowMajor, ToCblas(transA), ToCblas(transB), m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+		}
+
+		void Gemv(Operation trans, unsigned int m, unsigned int n, double alpha, const double* a, unsigned int lda,
+			const double* x, unsigned int incx, double beta, double* y, unsigned int incy)
+		{
+			cblas_dgemv(CblasRowMajor, ToCblas(trans), m, n, alpha, a, lda, x, incx, beta, y, incy);
+		}
+
+		void Gemv(Operation trans, unsigned int m, unsigned int n, float alpha, const float* a, unsigned int lda,
+			const float* x, unsigned int incx, float beta, float* y, unsigned int incy)
+		{
+			cblas_sgemv(CblasRowMajor, ToCblas(trans), m, n, alpha, a, lda, x, incx, beta, y, incy);
+		}
+
+		void Ger(unsigned int m, unsigned int n, double alpha, const double* x, unsigned int incx, const double* y, unsigned int incy, double* a, unsigned int lda)
+		{
+			cblas_dger(CblasRowMajor, m, n, alpha, x, incx, y, incy, a, lda);
+		}
+
+		void Ger(unsigned int m, unsigned int n, float alpha, const float* x, unsigned int incx, const float* y, unsigned int incy, float* a, unsigned int lda)
+		{
+			cblas_sger(CblasRowMajor, m, n, alpha, x, incx, y, incy, a, lda);
+		}
+
+		void Axpy(unsigned int n, double alpha, const double* x, unsigned int incx, double* y, unsigned int incy)
+		{
+			cblas_daxpy(n, alpha, x, incx, y, incy);
+		}
+
+		void Axpy(unsigned int n, float alpha, const float* x, unsigned int incx, float* y, unsigned int incy)
+		{
+			cblas_saxpy(n, alpha, x, incx, y, incy);
+		}
+	}
+}
+#endif // NN_USE_CBLAS
@@ -0,0 +1,44 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+#include "Gemm.h"
+
+namespace math
+{
+	// External CBLAS backend for the routines in Gemm.h, compiled in when the library is built with NN_USE_CBLAS defined
+	// cblas.h has to be on the include path and a CBLAS library (e.g. OpenBLAS) linked into the final binary
+	// The arguments are forwarded as they are, the callers in Gemm.cpp take care of empty operands
+	namespace cblas
+	{
+		void Gemm(Operation transA, Operation transB, unsigned int m, unsigned int n, unsigned int k, double alpha, const double* a, unsigned int lda,
+			const double* b, unsigned int ldb, double beta, double* c, unsigned int ldc);
+		void Gemm(Operation transA, Operation transB, unsigned int m, unsigned int n, unsigned int k, float alpha, const float* a, unsigned int lda,
+			const float* b, unsigned int ldb, float beta, float* c, unsigned int ldc);
+		void Gemv(Operation trans, unsigned int m, unsigned int n, double alpha, const double* a, unsigned int lda,
+			const double* x, unsigned int incx, double beta, double* y, unsigned int incy);
+		void Gemv(Operation trans, unsigned int m, unsigned int n, float alpha, const float* a, unsigned int lda,
+			const float* x, unsigned int incx, float beta, float* y, unsigned int incy);
+		void Ger(unsigned int m, unsigned int n, double alpha, const double* x, unsigned int incx, const double* y, unsigned int incy, double* a, unsigned int lda);
+		void Ger(unsigned int m, unsigned int n, float alpha, const float* x, unsigned int incx, const float* y, unsigned int incy, float* a, unsigned int lda);
+		void Axpy(unsigned int n, double alpha, const double* x, unsigned int incx, double* y, unsigned int incy);
+		void Axpy(unsigned int n, float alpha, const float* x, unsigned int incx, float* y, unsigned int incy);
+	}
+}
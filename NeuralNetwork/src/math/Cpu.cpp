@@ -0,0 +1,95 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "Cpu.h"
+
+#ifdef NN_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif // _MSC_VER
+#endif // NN_X86
+
+namespace math
+{
+	namespace cpu
+	{
+		namespace
+		{
+#ifdef NN_X86
+			void CpuId(unsigned int leaf, unsigned int subleaf, unsigned int registers[4])
+			{
+#ifdef _MSC_VER
+				int info[4];
+				__cpuidex(info, (int)leaf, (int)subleaf);
+				for (int i = 0; i < 4; ++i)
+					registers[i] = (unsigned int)info[i];
+#else
+				__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif // _MSC_VER
+			}
+
+			unsigned long long ReadXCR0()
+			{
+#ifdef _MSC_VER
+				return _xgetbv(0);
+#else
+				unsigned int eax, edx;
+				__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+				return ((unsigned long long)edx << 32) | eax;
+#endif // _MSC_VER
+			}
+#endif // NN_X86
+
+			Features DetectFeatures()
+			{
+				Features features;
+#ifdef NN_X86
+				unsigned int regs[4];
+				CpuId(0, 0, regs);
+				unsigned int maxLeaf = regs[0];
+				CpuId(1, 0, regs);
+				bool osxsave = (regs[2] & (1u << 27)) != 0;
+				bool fma = (regs[2] & (1u << 12)) != 0;
+				bool f16c = (regs[2] & (1u << 29)) != 0;
+				if (!osxsave || maxLeaf < 7)
+					return features;
+				unsigned long long xcr0 = ReadXCR0();
+				bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+				bool zmmEnabled = (xcr0 & 0xE6) == 0xE6;
+				CpuId(7, 0, regs);
+				features.AVX2 = ymmEnabled && (regs[1] & (1u << 5)) != 0;
+				features.FMA = ymmEnabled && fma;
+				features.F16C = ymmEnabled && f16c;
+				features.AVX512F = zmmEnabled && (regs[1] & (1u << 16)) != 0;
+				features.AVX512VNNI = features.AVX512F && (regs[2] & (1u << 11)) != 0;
+#endif // NN_X86
+				return features;
+			}
+		}
+
+		const Features& GetFeatures()
+		{
+			static const Features features = DetectFeatures();
+			return features;
+		}
+	}
+}
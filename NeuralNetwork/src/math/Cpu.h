@@ -0,0 +1,58 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define NN_X86
+#endif // x86
+
+// Lets a single function use wider instruction sets than the rest of the translation unit
+#if defined(NN_X86) && (defined(__GNUC__) || defined(__clang__))
+#define NN_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define NN_TARGET_AVX512 __attribute__((target("avx512f")))
+#define NN_TARGET_AVX512VNNI __attribute__((target("avx512f,avx512vnni")))
+#define NN_TARGET_AVX2_F16C __attribute__((target("avx2,fma,f16c")))
+#else
+#define NN_TARGET_AVX2
+#define NN_TARGET_AVX512
+#define NN_TARGET_AVX512VNNI
+#define NN_TARGET_AVX2_F16C
+#endif
+
+namespace math
+{
+	namespace cpu
+	{
+		struct Features
+		{
+			bool AVX2 = false;
+			bool FMA = false;
+			bool AVX512F = false;
+			// 8-bit dot products (vpdpbusd) on 512-bit registers
+			bool AVX512VNNI = false;
+			// Packed IEEE half <-> float conversions (vcvtph2ps, vcvtps2ph)
+			bool F16C = false;
+		};
+
+		// Detected once with cpuid, also checks that the OS saves the wide register state
+		const Features& GetFeatures();
+	}
+}
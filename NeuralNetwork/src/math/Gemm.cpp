@@ -0,0 +1,477 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "Gemm.h"
+#include "Cpu.h"
+#include "ThreadPool.h"
+#include "Kernels.h"
+#include "Cblas.h"
+#include <vector>
+#include <algorithm>
+
+#ifdef NN_X86
+#include <immintrin.h>
+#endif // NN_X86
+
+namespace math
+{
+	namespace
+	{
+		// Register tile computed by the micro-kernel, one cache line of C per row
+		const unsigned int MR = 4;
+		template<typename T> struct Tile { static const unsigned int NR = 64 / sizeof(T); };
+		// Cache blocking: MC x KC block of A stays in L2, KC x NR sliver of B in L1, KC x NC panel of B in L3
+		const unsigned int MC = 96;
+		const unsigned int KC = 256;
+		const unsigned int NC = 4096;
+		// Below this many multiply-adds packing costs more than it saves
+		const unsigned long long PACKING_THRESHOLD = 32 * 32 * 32;
+		// Below this many multiply-adds waking the thread pool costs more than it saves
+		const unsigned long long PARALLEL_THRESHOLD = 128 * 128 * 128;
+		const unsigned long long PARALLEL_GEMV_THRESHOLD = 1024 * 1024;
+
+		template<typename T>
+		void ScaleOutput(unsigned int m, unsigned int n, T beta, T* c, unsigned int ldc)
+		{
+			if (beta == 1)
+				return;
+			for (unsigned int i = 0; i < m; ++i)
+			{
+				T* row = c + i*ldc;
+				if (beta == 0)
+					std::fill(row, row + n, T(0));
+				else
+					std::for_each(row, row + n, [beta](T& x) { x *= beta; });
+			}
+		}
+
+		// Matrix-vector product, one contiguous dot product per row of A
+		template<typename T>
+		void Gemv(unsigned int m, unsigned int k, T alpha, const T* a, unsigned int lda, const T* x, unsigned int incx, T* y, unsigned int incy)
+		{
+			for (unsigned int i = 0; i < m; ++i)
+			{
+				const T* row = a + (size_t)i*lda;
+				T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+				unsigned int p = 0;
+				for (; p + 4 <= k; p += 4)
+				{
+					s0 += row[p] * x[p*incx];
+					s1 += row[p + 1] * x[(p + 1)*incx];
+					s2 += row[p + 2] * x[(p + 2)*incx];
+					s3 += row[p + 3] * x[(p + 3)*incx];
+				}
+				for (; p < k; ++p)
+					s0 += row[p] * x[p*incx];
+				y[i*incy] += alpha * ((s0 + s1) + (s2 + s3));
+			}
+		}
+
+		// Transposed matrix-vector product, A is stored k x m and each of its rows is added to y scaled by x[p]
+		template<typename T>
+		void GemvTransposed(unsigned int m, unsigned int k, T alpha, const T* a, unsigned int lda, const T* x, unsigned int incx, T* y, unsigned int incy)
+		{
+			for (unsigned int p = 0; p < k; ++p)
+			{
+				const T xp = alpha * x[p*incx];
+				const T* row = a + (size_t)p*lda;
+				if (incy == 1)
+				{
+					for (unsigned int i = 0; i < m; ++i)
+						y[i] += xp * row[i];
+				}
+				else
+				{
+					for (unsigned int i = 0; i < m; ++i)
+						y[i*incy] += xp * row[i];
+				}
+			}
+		}
+
+		// Element strides of op(X), so that op(X)(i, j) = x[i*Row + j*Column] whether or not X is transposed
+		struct Strides
+		{
+			unsigned int Row;
+			unsigned int Column;
+			Strides(Operation operation, unsigned int ld) : Row(operation == TRANSPOSE ? 1 : ld), Column(operation == TRANSPOSE ? ld : 1) {}
+		};
+
+		// Unpacked i-k-j loop for products too small to amortize packing
+		template<typename T>
+		void SmallGemm(unsigned int m, unsigned int n, unsigned int k, T alpha, const T* a, Strides sa, const T* b, Strides sb, T* c, unsigned int ldc)
+		{
+			for (unsigned int i = 0; i < m; ++i)
+			{
+				T* cRow = c + (size_t)i*ldc;
+				for (unsigned int p = 0; p < k; ++p)
+				{
+					const T aip = alpha * a[(size_t)i*sa.Row + (size_t)p*sa.Column];
+					const T* bRow = b + (size_t)p*sb.Row;
+					if (sb.Column == 1)
+					{
+						for (unsigned int j = 0; j < n; ++j)
+							cRow[j] += aip * bRow[j];
+					}
+					else
+					{
+						for (unsigned int j = 0; j < n; ++j)
+							cRow[j] += aip * bRow[(size_t)j*sb.Column];
+					}
+				}
+			}
+		}
+
+		// Packs an mc x kc block of op(A) into MR-row slivers stored column by column, zero padding the last sliver
+		template<typename T>
+		void PackA(unsigned int mc, unsigned int kc, const T* a, Strides sa, T* packed)
+		{
+			for (unsigned int i = 0; i < mc; i += MR)
+			{
+				unsigned int rows = std::min(MR, mc - i);
+				for (unsigned int p = 0; p < kc; ++p)
+				{
+					for (unsigned int r = 0; r < rows; ++r)
+						*packed++ = a[(size_t)(i + r)*sa.Row + (size_t)p*sa.Column];
+					for (unsigned int r = rows; r < MR; ++r)
+						*packed++ = 0;
+				}
+			}
+		}
+
+		// Packs a kc x nc panel of op(B) into NR-column slivers stored row by row, zero padding the last sliver
+		template<typename T>
+		void PackB(unsigned int kc, unsigned int nc, const T* b, Strides sb, T* packed)
+		{
+			const unsigned int NR = Tile<T>::NR;
+			for (unsigned int j = 0; j < nc; j += NR)
+			{
+				unsigned int cols = std::min(NR, nc - j);
+				for (unsigned int p = 0; p < kc; ++p)
+				{
+					const T* row = b + (size_t)p*sb.Row + (size_t)j*sb.Column;
+					for (unsigned int col = 0; col < cols; ++col)
+						*packed++ = row[(size_t)col*sb.Column];
+					for (unsigned int col = cols; col < NR; ++col)
+						*packed++ = 0;
+				}
+			}
+		}
+
+		// Computes an MR x NR tile of A*B from packed slivers, keeping the accumulators in registers
+		template<typename T>
+		void MicroKernel(unsigned int kc, const T* a, const T* b, T* ab)
+		{
+			const unsigned int NR = Tile<T>::NR;
+			T acc[MR][NR] = {};
+			for (unsigned int p = 0; p < kc; ++p, a += MR, b += NR)
+			{
+				for (unsigned int i = 0; i < MR; ++i)
+				{
+					const T ai = a[i];
+					for (unsigned int j = 0; j < NR; ++j)
+						acc[i][j] += ai * b[j];
+				}
+			}
+			for (unsigned int i = 0; i < MR; ++i)
+				for (unsigned int j = 0; j < NR; ++j)
+					ab[i*NR + j] = acc[i][j];
+		}
+
+#ifdef NN_X86
+		// Each row of the tile is two ymm registers, eight independent FMA chains in total
+		NN_TARGET_AVX2 void MicroKernelAvx2(unsigned int kc, const double* a, const double* b, double* ab)
+		{
+			__m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd(), c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+			__m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd(), c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+			for (unsigned int p = 0; p < kc; ++p, a += MR, b += 8)
+			{
+				__m256d b0 = _mm256_loadu_pd(b), b1 = _mm256_loadu_pd(b + 4);
+				__m256d ai = _mm256_broadcast_sd(a);
+				c00 = _mm256_fmadd_pd(ai, b0, c00); c01 = _mm256_fmadd_pd(ai, b1, c01);
+				ai = _mm256_broadcast_sd(a + 1);
+				c10 = _mm256_fmadd_pd(ai, b0, c10); c11 = _mm256_fmadd_pd(ai, b1, c11);
+				ai = _mm256_broadcast_sd(a + 2);
+				c20 = _mm256_fmadd_pd(ai, b0, c20); c21 = _mm256_fmadd_pd(ai, b1, c21);
+				ai = _mm256_broadcast_sd(a + 3);
+				c30 = _mm256_fmadd_pd(ai, b0, c30); c31 = _mm256_fmadd_pd(ai, b1, c31);
+			}
+			_mm256_storeu_pd(ab, c00); _mm256_storeu_pd(ab + 4, c01);
+			_mm256_storeu_pd(ab + 8, c10); _mm256_storeu_pd(ab + 12, c11);
+			_mm256_storeu_pd(ab + 16, c20); _mm256_storeu_pd(ab + 20, c21);
+			_mm256_storeu_pd(ab + 24, c30); _mm256_storeu_pd(ab + 28, c31);
+		}
+
+		NN_TARGET_AVX2 void MicroKernelAvx2(unsigned int kc, const float* a, const float* b, float* ab)
+		{
+			__m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps(), c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+			__m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps(), c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+			for (unsigned int p = 0; p < kc; ++p, a += MR, b += 16)
+			{
+				__m256 b0 = _mm256_loadu_ps(b), b1 = _mm256_loadu_ps(b + 8);
+				__m256 ai = _mm256_broadcast_ss(a);
+				c00 = _mm256_fmadd_ps(ai, b0, c00); c01 = _mm256_fmadd_ps(ai, b1, c01);
+				ai = _mm256_broadcast_ss(a + 1);
+				c10 = _mm256_fmadd_ps(ai, b0, c10); c11 = _mm256_fmadd_ps(ai, b1, c11);
+				ai = _mm256_broadcast_ss(a + 2);
+				c20 = _mm256_fmadd_ps(ai, b0, c20); c21 = _mm256_fmadd_ps(ai, b1, c21);
+				ai = _mm256_broadcast_ss(a + 3);
+				c30 = _mm256_fmadd_ps(ai, b0, c30); c31 = _mm256_fmadd_ps(ai, b1, c31);
+			}
+			_mm256_storeu_ps(ab, c00); _mm256_storeu_ps(ab + 8, c01);
+			_mm256_storeu_ps(ab + 16, c10); _mm256_storeu_ps(ab + 24, c11);
+			_mm256_storeu_ps(ab + 32, c20); _mm256_storeu_ps(ab + 40, c21);
+			_mm256_storeu_ps(ab + 48, c30); _mm256_storeu_ps(ab + 56, c31);
+		}
+#endif // NN_X86
+
+		template<typename T>
+		struct MicroKernelSelector
+		{
+			typedef void(*Kernel)(unsigned int, const T*, const T*, T*);
+			static Kernel Select()
+			{
+#ifdef NN_X86
+				const cpu::Features& features = cpu::GetFeatures();
+				if (features.AVX2 && features.FMA)
+					return MicroKernelAvx2;
+#endif // NN_X86
+				return MicroKernel<T>;
+			}
+		};
+
+		template<typename T>
+		void PackedGemm(unsigned int m, unsigned int n, unsigned int k, T alpha, const T* a, Strides sa, const T* b, Strides sb, T* c, unsigned int ldc)
+		{
+			const unsigned int NR = Tile<T>::NR;
+			// Packing buffers are reused across calls so steady-state multiplies do not allocate
+			thread_local std::vector<T> packedA;
+			thread_local std::vector<T> packedB;
+			packedA.resize(std::max<size_t>(packedA.size(), MC*KC));
+			packedB.resize(std::max<size_t>(packedB.size(), (size_t)KC*((std::min(n, NC) + NR - 1) / NR * NR)));
+			T ab[MR*NR];
+			static const typename MicroKernelSelector<T>::Kernel microKernel = MicroKernelSelector<T>::Select();
+
+			for (unsigned int jc = 0; jc < n; jc += NC)
+			{
+				unsigned int nc = std::min(NC, n - jc);
+				for (unsigned int pc = 0; pc < k; pc += KC)
+				{
+					unsigned int kc = std::min(KC, k - pc);
+					PackB(kc, nc, b + (size_t)pc*sb.Row + (size_t)jc*sb.Column, sb, packedB.data());
+					for (unsigned int ic = 0; ic < m; ic += MC)
+					{
+						unsigned int mc = std::min(MC, m - ic);
+						PackA(mc, kc, a + (size_t)ic*sa.Row + (size_t)pc*sa.Column, sa, packedA.data());
+						for (unsigned int jr = 0; jr < nc; jr += NR)
+						{
+							unsigned int cols = std::min(NR, nc - jr);
+							for (unsigned int ir = 0; ir < mc; ir += MR)
+							{
+								unsigned int rows = std::min(MR, mc - ir);
+								microKernel(kc, packedA.data() + ir*kc, packedB.data() + jr*kc, ab);
+								T* tile = c + (size_t)(ic + ir)*ldc + jc + jr;
+								for (unsigned int i = 0; i < rows; ++i)
+									for (unsigned int j = 0; j < cols; ++j)
+										tile[i*ldc + j] += alpha * ab[i*NR + j];
+							}
+						}
+					}
+				}
+			}
+		}
+
+		// Splits C into a grid of tiles, several per thread, and computes each one as an independent packed GEMM
+		// Every worker packs into its own thread-local buffers
+		template<typename T>
+		void ParallelGemm(unsigned int m, unsigned int n, unsigned int k, T alpha, const T* a, Strides sa, const T* b, Strides sb, T* c, unsigned int ldc)
+		{
+			const unsigned int NR = Tile<T>::NR;
+			ThreadPool& pool = ThreadPool::GetInstance();
+			unsigned int rowTiles = (m + MC - 1) / MC;
+			unsigned int columnTiles = std::max(1u, std::min((2 * pool.GetThreadCount() + rowTiles - 1) / rowTiles, (n + NR - 1) / NR));
+			unsigned int tileWidth = ((n + columnTiles - 1) / columnTiles + NR - 1) / NR * NR;
+			columnTiles = (n + tileWidth - 1) / tileWidth;
+			pool.ParallelFor(rowTiles * columnTiles, [=](unsigned int tile)
+			{
+				unsigned int i = tile / columnTiles * MC;
+				unsigned int j = tile % columnTiles * tileWidth;
+				PackedGemm(std::min(MC, m - i), std::min(tileWidth, n - j), k, alpha, a + (size_t)i*sa.Row, sa,
+					b + (size_t)j*sb.Column, sb, c + (size_t)i*ldc + j, ldc);
+			});
+		}
+
+		// Splits the rows of A into contiguous bands for large matrix-vector products
+		template<typename T>
+		void ParallelGemv(unsigned int m, unsigned int k, T alpha, const T* a, unsigned int lda, const T* x, unsigned int incx, T* y, unsigned int incy)
+		{
+			ThreadPool& pool = ThreadPool::GetInstance();
+			unsigned int bands = std::min(pool.GetThreadCount(), (m + MR - 1) / MR);
+			unsigned int bandHeight = (m + bands - 1) / bands;
+			pool.ParallelFor(bands, [=](unsigned int band)
+			{
+				unsigned int i = band * bandHeight;
+				if (i < m)
+					Gemv(std::min(bandHeight, m - i), k, alpha, a + (size_t)i*lda, lda, x, incx, y + (size_t)i*incy, incy);
+			});
+		}
+
+		template<typename T>
+		void AxpyImpl(unsigned int n, T alpha, const T* x, unsigned int incx, T* y, unsigned int incy)
+		{
+#ifdef NN_USE_CBLAS
+			cblas::Axpy(n, alpha, x, incx, y, incy);
+#else
+			if (incx == 1 && incy == 1)
+				kernel::Axpy(n, alpha, x, y);
+			else
+				for (unsigned int i = 0; i < n; ++i)
+					y[(size_t)i*incy] += alpha * x[(size_t)i*incx];
+#endif // NN_USE_CBLAS
+		}
+
+		// Each row of A gets one vectorized AXPY with y
+		template<typename T>
+		void GerImpl(unsigned int m, unsigned int n, T alpha, const T* x, unsigned int incx, const T* y, unsigned int incy, T* a, unsigned int lda)
+		{
+			if (m == 0 || n == 0)
+				return;
+#ifdef NN_USE_CBLAS
+			cblas::Ger(m, n, alpha, x, incx, y, incy, a, lda);
+#else
+			if (incy == 1)
+			{
+				for (unsigned int i = 0; i < m; ++i)
+					kernel::Axpy(n, alpha * x[(size_t)i*incx], y, a + (size_t)i*lda);
+				return;
+			}
+			for (unsigned int i = 0; i < m; ++i)
+			{
+				const T axi = alpha * x[(size_t)i*incx];
+				T* row = a + (size_t)i*lda;
+				for (unsigned int j = 0; j < n; ++j)
+					row[j] += axi * y[(size_t)j*incy];
+			}
+#endif // NN_USE_CBLAS
+		}
+
+		template<typename T>
+		void GemmImpl(Operation transA, Operation transB, unsigned int m, unsigned int n, unsigned int k, T alpha, const T* a, unsigned int lda,
+			const T* b, unsigned int ldb, T beta, T* c, unsigned int ldc)
+		{
+			if (m == 0 || n == 0)
+				return;
+			if (k == 0 || alpha == 0)
+			{
+				ScaleOutput(m, n, beta, c, ldc);
+				return;
+			}
+			Strides sa(transA, lda), sb(transB, ldb);
+#ifdef NN_USE_CBLAS
+			// Products with a single column of B are matrix-vector products over A as stored
+			if (n == 1)
+				cblas::Gemv(transA, transA == TRANSPOSE ? k : m, transA == TRANSPOSE ? m : k, alpha, a, lda, b, sb.Row, beta, c, ldc);
+			else
+				cblas::Gemm(transA, transB, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+#else
+			ScaleOutput(m, n, beta, c, ldc);
+			const unsigned long long work = (unsigned long long)m*n*k;
+			if (n == 1 && transA == NO_TRANSPOSE && work >= PARALLEL_GEMV_THRESHOLD)
+				ParallelGemv(m, k, alpha, a, lda, b, sb.Row, c, ldc);
+			else if (n == 1 && transA == NO_TRANSPOSE)
+				Gemv(m, k, alpha, a, lda, b, sb.Row, c, ldc);
+			else if (n == 1)
+				GemvTransposed(m, k, alpha, a, lda, b, sb.Row, c, ldc);
+			else if (work <= PACKING_THRESHOLD || m < MR)
+				SmallGemm(m, n, k, alpha, a, sa, b, sb, c, ldc);
+			else if (work >= PARALLEL_THRESHOLD)
+				ParallelGemm(m, n, k, alpha, a, sa, b, sb, c, ldc);
+			else
+				PackedGemm(m, n, k, alpha, a, sa, b, sb, c, ldc);
+#endif // NN_USE_CBLAS
+		}
+	}
+
+	void Gemm(unsigned int m, unsigned int n, unsigned int k, double alpha, const double* a, unsigned int lda,
+		const double* b, unsigned int ldb, double beta, double* c, unsigned int ldc)
+	{
+		GemmImpl(NO_TRANSPOSE, NO_TRANSPOSE, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+	}
+
+	void Gemm(unsigned int m, unsigned int n, unsigned int k, float alpha, const float* a, unsigned int lda,
+		const float* b, unsigned int ldb, float beta, float* c, unsigned int ldc)
+	{
+		GemmImpl(NO_TRANSPOSE, NO_TRANSPOSE, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+	}
+
+	void Gemm(Operation transA, Operation transB, unsigned int m, unsigned int n, unsigned int k, double alpha, const double* a, unsigned int lda,
+		const double* b, unsigned int ldb, double beta, double* c, unsigned int ldc)
+	{
+		GemmImpl(transA, transB, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+	}
+
+	void Gemm(Operation transA, Operation transB, unsigned int m, unsigned int n, unsigned int k, float alpha, const float* a, unsigned int lda,
+		const float* b, unsigned int ldb, float beta, float* c, unsigned int ldc)
+	{
+		GemmImpl(transA, transB, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+	}
+
+	void Gemv(Operation trans, unsigned int m, unsigned int n, double alpha, const double* a, unsigned int lda,
+		const double* x, unsigned int incx, double beta, double* y, unsigned int incy)
+	{
+		unsigned int length = trans == TRANSPOSE ? n : m;
+		GemmImpl(trans, NO_TRANSPOSE, length, 1, trans == TRANSPOSE ? m : n, alpha, a, lda, x, incx, beta, y, incy);
+	}
+
+	void Gemv(Operation trans, unsigned int m, unsigned int n, float alpha, const float* a, unsigned int lda,
+		const float* x, unsigned int incx, float beta, float* y, unsigned int incy)
+	{
+		unsigned int length = trans == TRANSPOSE ? n : m;
+		GemmImpl(trans, NO_TRANSPOSE, length, 1, trans == TRANSPOSE ? m : n, alpha, a, lda, x, incx, beta, y, incy);
+	}
+
+	void Ger(unsigned int m, unsigned int n, double alpha, const double* x, unsigned int incx, const double* y, unsigned int incy, double* a, unsigned int lda)
+	{
+		GerImpl(m, n, alpha, x, incx, y, incy, a, lda);
+	}
+
+	void Ger(unsigned int m, unsigned int n, float alpha, const float* x, unsigned int incx, const float* y, unsigned int incy, float* a, unsigned int lda)
+	{
+		GerImpl(m, n, alpha, x, incx, y, incy, a, lda);
+	}
+
+	void Axpy(unsigned int n, double alpha, const double* x, unsigned int incx, double* y, unsigned int incy)
+	{
+		AxpyImpl(n, alpha, x, incx, y, incy);
+	}
+
+	void Axpy(unsigned int n, float alpha, const float* x, unsigned int incx, float* y, unsigned int incy)
+	{
+		AxpyImpl(n, alpha, x, incx, y, incy);
+	}
+
+	const char* GetBlasBackendName()
+	{
+#ifdef NN_USE_CBLAS
+		return "CBLAS";
+#else
+		return "Built-in";
+#endif // NN_USE_CBLAS
+	}
+}
@@ -0,0 +1,62 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+namespace math
+{
+	// Whether a GEMM/GEMV operand is used as stored or transposed, read in place without a copy
+	enum Operation
+	{
+		NO_TRANSPOSE,
+		TRANSPOSE
+	};
+
+	// Row-major general matrix multiply: C = alpha * A * B + beta * C
+	// A is (m x k) with row stride lda, B is (k x n) with row stride ldb, C is (m x n) with row stride ldc
+	void Gemm(unsigned int m, unsigned int n, unsigned int k, double alpha, const double* a, unsigned int lda,
+		const double* b, unsigned int ldb, double beta, double* c, unsigned int ldc);
+	void Gemm(unsigned int m, unsigned int n, unsigned int k, float alpha, const float* a, unsigned int lda,
+		const float* b, unsigned int ldb, float beta, float* c, unsigned int ldc);
+
+	// C = alpha * op(A) * op(B) + beta * C, where op(A) is (m x k) and op(B) is (k x n)
+	// lda and ldb are the row strides of A and B as stored, before the transposition
+	void Gemm(Operation transA, Operation transB, unsigned int m, unsigned int n, unsigned int k, double alpha, const double* a, unsigned int lda,
+		const double* b, unsigned int ldb, double beta, double* c, unsigned int ldc);
+	void Gemm(Operation transA, Operation transB, unsigned int m, unsigned int n, unsigned int k, float alpha, const float* a, unsigned int lda,
+		const float* b, unsigned int ldb, float beta, float* c, unsigned int ldc);
+
+	// y = alpha * op(A) * x + beta * y, where A is stored (m x n) with row stride lda
+	void Gemv(Operation trans, unsigned int m, unsigned int n, double alpha, const double* a, unsigned int lda,
+		const double* x, unsigned int incx, double beta, double* y, unsigned int incy);
+	void Gemv(Operation trans, unsigned int m, unsigned int n, float alpha, const float* a, unsigned int lda,
+		const float* x, unsigned int incx, float beta, float* y, unsigned int incy);
+
+	// Rank-1 update in place: A += alpha * x * y^T, where A is (m x n) with row stride lda
+	void Ger(unsigned int m, unsigned int n, double alpha, const double* x, unsigned int incx, const double* y, unsigned int incy, double* a, unsigned int lda);
+	void Ger(unsigned int m, unsigned int n, float alpha, const float* x, unsigned int incx, const float* y, unsigned int incy, float* a, unsigned int lda);
+
+	// y += alpha * x over n elements, with the strides incx and incy
+	void Axpy(unsigned int n, double alpha, const double* x, unsigned int incx, double* y, unsigned int incy);
+	void Axpy(unsigned int n, float alpha, const float* x, unsigned int incx, float* y, unsigned int incy);
+
+	// The routines above run on the built-in kernels, or on an external CBLAS when the library is built with NN_USE_CBLAS
+	const char* GetBlasBackendName();
+}
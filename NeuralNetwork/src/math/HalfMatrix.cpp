@@ -0,0 +1,292 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "HalfMatrix.h"
+#include "Cpu.h"
+#include "ThreadPool.h"
+#include <cmath>
+#include <cstring>
+
+#ifdef NN_X86
+#include <immintrin.h>
+#endif // NN_X86
+
+namespace math
+{
+	uint16_t FloatToHalf(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		const uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+		const uint32_t magnitude = bits & 0x7FFFFFFF;
+		// Infinity and NaN, NaN keeps a mantissa bit set
+		if (magnitude >= 0x7F800000)
+			return sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 : 0);
+		// 65520 and above round past the largest half
+		if (magnitude >= 0x477FF000)
+			return sign | 0x7C00;
+		// Below 2^-14 the result is subnormal, its mantissa counts units of 2^-24
+		if (magnitude < 0x38800000)
+		{
+			float absolute;
+			std::memcpy(&absolute, &magnitude, sizeof(absolute));
+			return sign | (uint16_t)std::nearbyint(absolute * 16777216.0f);
+		}
+		// Rebias the exponent from 127 to 15 and round the mantissa from 23 to 10 bits, a carry moves into the exponent
+		const uint32_t rounded = magnitude + 0xFFF + ((magnitude >> 13) & 1);
+		return sign | (uint16_t)((rounded - 0x38000000) >> 13);
+	}
+
+	float HalfToFloat(uint16_t value)
+	{
+		const uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+		const uint32_t exponent = (value >> 10) & 0x1F;
+		const uint32_t mantissa = value & 0x3FF;
+		uint32_t bits;
+		if (exponent == 0)
+		{
+			float subnormal = (float)mantissa * (1.0f / 16777216.0f);
+			std::memcpy(&bits, &subnormal, sizeof(bits));
+			bits |= sign;
+		}
+		else if (exponent == 0x1F)
+			bits = sign | 0x7F800000 | (mantissa << 13);
+		else
+			bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+		float result;
+		std::memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+
+	uint16_t FloatToBFloat16(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		// Quiet the NaN so that truncating the mantissa can not turn it into infinity
+		if ((bits & 0x7FFFFFFF) > 0x7F800000)
+			return (uint16_t)((bits >> 16) | 0x40);
+		return (uint16_t)((bits + 0x7FFF + ((bits >> 16) & 1)) >> 16);
+	}
+
+	float BFloat16ToFloat(uint16_t value)
+	{
+		const uint32_t bits = (uint32_t)value << 16;
+		float result;
+		std::memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+}
+
+namespace
+{
+	// Below this many multiply-adds waking the thread pool costs more than it saves
+	const unsigned long long PARALLEL_THRESHOLD = 1024 * 1024;
+
+	typedef float(*DotKernel)(size_t, const uint16_t*, const float*);
+
+	// Every kernel takes n as a multiple of 32
+	float DotHalfPortable(size_t n, const uint16_t* a, const float* b)
+	{
+		float sum = 0;
+		for (size_t i = 0; i < n; ++i)
+			sum += math::HalfToFloat(a[i]) * b[i];
+		return sum;
+	}
+
+	float DotBFloat16Portable(size_t n, const uint16_t* a, const float* b)
+	{
+		float sum = 0;
+		for (size_t i = 0; i < n; ++i)
+			sum += math::BFloat16ToFloat(a[i]) * b[i];
+		return sum;
+	}
+
+#ifdef NN_X86
+	NN_TARGET_AVX2 inline float HorizontalSum(__m256 a)
+	{
+		__m128 sum = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+		return _mm_cvtss_f32(sum);
+	}
+
+	// vcvtph2ps widens 8 halves per instruction
+	NN_TARGET_AVX2_F16C float DotHalfAvx2(size_t n, const uint16_t* a, const float* b)
+	{
+		__m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+		for (size_t i = 0; i < n; i += 16)
+		{
+			acc0 = _mm256_fmadd_ps(_mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(a + i))), _mm256_loadu_ps(b + i), acc0);
+			acc1 = _mm256_fmadd_ps(_mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(a + i + 8))), _mm256_loadu_ps(b + i + 8), acc1);
+		}
+		return HorizontalSum(_mm256_add_ps(acc0, acc1));
+	}
+
+	// bfloat16 is widened by moving it into the upper half of each 32-bit lane
+	NN_TARGET_AVX2 inline __m256 WidenBFloat16(const uint16_t* a)
+	{
+		return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)a)), 16));
+	}
+
+	NN_TARGET_AVX2 float DotBFloat16Avx2(size_t n, const uint16_t* a, const float* b)
+	{
+		__m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+		for (size_t i = 0; i < n; i += 16)
+		{
+			acc0 = _mm256_fmadd_ps(WidenBFloat16(a + i), _mm256_loadu_ps(b + i), acc0);
+			acc1 = _mm256_fmadd_ps(WidenBFloat16(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+		}
+		return HorizontalSum(_mm256_add_ps(acc0, acc1));
+	}
+#endif // NN_X86
+
+	DotKernel SelectDotKernel(math::StorageFormat format)
+	{
+#ifdef NN_X86
+		const math::cpu::Features& features = math::cpu::GetFeatures();
+		if (features.AVX2 && features.FMA)
+		{
+			if (format == math::BFLOAT16)
+				return DotBFloat16Avx2;
+			if (features.F16C)
+				return DotHalfAvx2;
+		}
+#endif // NN_X86
+		return format == math::BFLOAT16 ? DotBFloat16Portable : DotHalfPortable;
+	}
+
+	DotKernel Dot(math::StorageFormat format)
+	{
+		static const DotKernel kernels[] = { SelectDotKernel(math::FLOAT16), SelectDotKernel(math::BFLOAT16) };
+		return kernels[format];
+	}
+
+	unsigned int PaddedColumns(unsigned int columns)
+	{
+		return (columns + 31) / 32 * 32;
+	}
+
+	inline uint16_t Narrow(math::StorageFormat format, Scalar value)
+	{
+		return format == math::BFLOAT16 ? math::FloatToBFloat16((float)value) : math::FloatToHalf((float)value);
+	}
+
+	inline float Widen(math::StorageFormat format, uint16_t value)
+	{
+		return format == math::BFLOAT16 ? math::BFloat16ToFloat(value) : math::HalfToFloat(value);
+	}
+}
+
+HalfMatrix::HalfMatrix() : m_Rows(0), m_Columns(0), m_Stride(0), m_Format(math::FLOAT16)
+{
+}
+
+HalfMatrix::HalfMatrix(const MatrixView & matrix, math::StorageFormat format) : m_Rows(matrix.GetHeight()), m_Columns(matrix.GetWidth()),
+	m_Stride(PaddedColumns(matrix.GetWidth())), m_Format(format), m_Data((size_t)m_Rows*m_Stride, 0)
+{
+	for (unsigned int i = 0; i < m_Rows; ++i)
+	{
+		const Scalar* row = matrix.GetData() + (size_t)i*matrix.GetStride();
+		uint16_t* narrowed = m_Data.data() + (size_t)i*m_Stride;
+		for (unsigned int j = 0; j < m_Columns; ++j)
+			narrowed[j] = Narrow(format, row[j]);
+	}
+}
+
+size_t HalfMatrix::GetMemorySize() const
+{
+	return m_Data.size() * sizeof(uint16_t);
+}
+
+Matrix HalfMatrix::ToMatrix() const
+{
+	Matrix matrix(m_Rows, m_Columns, 0, Matrix::PaddedStride(m_Columns));
+	for (unsigned int i = 0; i < m_Rows; ++i)
+	{
+		const uint16_t* narrowed = m_Data.data() + (size_t)i*m_Stride;
+		Scalar* row = matrix.GetData() + (size_t)i*matrix.GetStride();
+		for (unsigned int j = 0; j < m_Columns; ++j)
+			row[j] = Widen(m_Format, narrowed[j]);
+	}
+	return matrix;
+}
+
+void HalfMatrix::SaveMatrix(std::ofstream & outfile) const
+{
+	outfile.write((char*)(&m_Rows), sizeof(m_Rows));
+	outfile.write((char*)(&m_Columns), sizeof(m_Columns));
+	for (unsigned int i = 0; i < m_Rows; ++i)
+		outfile.write((char*)(m_Data.data() + (size_t)i*m_Stride), sizeof(uint16_t)*m_Columns);
+}
+
+HalfMatrix HalfMatrix::LoadMatrix(std::ifstream & infile, math::StorageFormat format)
+{
+	HalfMatrix matrix;
+	infile.read((char*)&matrix.m_Rows, sizeof(matrix.m_Rows));
+	infile.read((char*)&matrix.m_Columns, sizeof(matrix.m_Columns));
+	matrix.m_Stride = PaddedColumns(matrix.m_Columns);
+	matrix.m_Format = format;
+	matrix.m_Data.assign((size_t)matrix.m_Rows*matrix.m_Stride, 0);
+	for (unsigned int i = 0; i < matrix.m_Rows; ++i)
+		infile.read((char*)(matrix.m_Data.data() + (size_t)i*matrix.m_Stride), sizeof(uint16_t)*matrix.m_Columns);
+	return matrix;
+}
+
+Matrix operator*(const HalfMatrix & left, const MatrixView & right)
+{
+#ifdef _DEBUG
+	if (left.m_Columns != right.GetHeight())
+		throw MatrixError("Matrices can not be multiplied!");
+#endif // _DEBUG
+	const unsigned int rows = left.m_Rows, columns = right.GetWidth(), depth = left.m_Columns, stride = left.m_Stride;
+	Matrix result(rows, columns, 0);
+	// Input columns are converted to float once, into zero-padded rows matching the weight stride
+	std::vector<float, math::WorkspaceAllocator<float>> inputs((size_t)columns*stride, 0);
+	for (unsigned int c = 0; c < columns; ++c)
+	{
+		float* column = inputs.data() + (size_t)c*stride;
+		for (unsigned int p = 0; p < depth; ++p)
+			column[p] = (float)right.GetData()[(size_t)p*right.GetStride() + c];
+	}
+	DotKernel dot = Dot(left.m_Format);
+	auto multiplyRows = [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; ++i)
+		{
+			const uint16_t* weights = left.m_Data.data() + (size_t)i*stride;
+			Scalar* out = result.GetData() + (size_t)i*result.GetStride();
+			for (unsigned int c = 0; c < columns; ++c)
+				out[c] = (Scalar)dot(stride, weights, inputs.data() + (size_t)c*stride);
+		}
+	};
+	math::ThreadPool& pool = math::ThreadPool::GetInstance();
+	if ((unsigned long long)rows*stride*columns >= PARALLEL_THRESHOLD && pool.GetThreadCount() > 1)
+	{
+		unsigned int bands = std::min(pool.GetThreadCount(), rows);
+		unsigned int bandHeight = (rows + bands - 1) / bands;
+		pool.ParallelFor(bands, [&](unsigned int band)
+		{
+			multiplyRows(std::min(rows, band*bandHeight), std::min(rows, (band + 1)*bandHeight));
+		});
+	}
+	else
+		multiplyRows(0, rows);
+	return result;
+}
@@ -0,0 +1,79 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include "Matrix.h"
+
+namespace math
+{
+	// 16-bit storage formats for weights, both are widened to float before any arithmetic
+	enum StorageFormat
+	{
+		// IEEE 754 binary16: 10-bit mantissa, range up to 65504
+		FLOAT16,
+		// Upper half of a float: 7-bit mantissa, same range as float
+		BFLOAT16
+	};
+
+	// Software conversions, rounding to nearest even, NaN stays NaN and overflow becomes infinity
+	uint16_t FloatToHalf(float value);
+	float HalfToFloat(uint16_t value);
+	uint16_t FloatToBFloat16(float value);
+	float BFloat16ToFloat(uint16_t value);
+}
+
+// Reduced-precision copy of a matrix, 4x smaller than double storage
+// Rows are padded with zeros to whole cache lines so the dot-product kernels never handle a tail
+class HalfMatrix
+{
+private:
+	unsigned int m_Rows;
+	unsigned int m_Columns;
+	unsigned int m_Stride;
+	math::StorageFormat m_Format;
+	std::vector<uint16_t, math::WorkspaceAllocator<uint16_t>> m_Data;
+public:
+	HalfMatrix();
+	HalfMatrix(const MatrixView& matrix, math::StorageFormat format);
+
+	inline unsigned int GetWidth() const { return m_Columns; }
+	inline unsigned int GetHeight() const { return m_Rows; }
+	inline unsigned int GetStride() const { return m_Stride; }
+	inline math::StorageFormat GetFormat() const { return m_Format; }
+	inline const uint16_t* GetData() const { return m_Data.data(); }
+	inline bool IsEmpty() const { return m_Data.empty(); }
+	// Bytes held by the stored values, padding included
+	size_t GetMemorySize() const;
+
+	Matrix ToMatrix() const;
+
+	// Same layout as Matrix::SaveMatrix with 2-byte values, the format is stored by the caller
+	void SaveMatrix(std::ofstream& outfile) const;
+	static HalfMatrix LoadMatrix(std::ifstream& infile, math::StorageFormat format);
+
+	friend Matrix operator*(const HalfMatrix& left, const MatrixView& right);
+};
+
+// GEMV per column of right, GEMM for several columns
+// Weights and inputs are widened to float and accumulated in float, the result is stored as Scalar
+Matrix operator*(const HalfMatrix& left, const MatrixView& right);
@@ -0,0 +1,303 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "Kernels.h"
+#include "Cpu.h"
+#include <algorithm>
+
+#ifdef NN_X86
+#include <immintrin.h>
+#endif // NN_X86
+
+namespace math
+{
+	namespace kernel
+	{
+		namespace
+		{
+#ifdef NN_X86
+			template<typename T> struct Avx2Vector;
+			template<typename T> struct Avx512Vector;
+
+			template<> struct Avx2Vector<double>
+			{
+				typedef __m256d Type;
+				static const size_t Width = 4;
+				NN_TARGET_AVX2 static Type Load(const double* p) { return _mm256_loadu_pd(p); }
+				NN_TARGET_AVX2 static void Store(double* p, Type v) { _mm256_storeu_pd(p, v); }
+				NN_TARGET_AVX2 static Type Set(double x) { return _mm256_set1_pd(x); }
+			};
+
+			template<> struct Avx2Vector<float>
+			{
+				typedef __m256 Type;
+				static const size_t Width = 8;
+				NN_TARGET_AVX2 static Type Load(const float* p) { return _mm256_loadu_ps(p); }
+				NN_TARGET_AVX2 static void Store(float* p, Type v) { _mm256_storeu_ps(p, v); }
+				NN_TARGET_AVX2 static Type Set(float x) { return _mm256_set1_ps(x); }
+			};
+
+			template<> struct Avx512Vector<double>
+			{
+				typedef __m512d Type;
+				static const size_t Width = 8;
+				NN_TARGET_AVX512 static Type Load(const double* p) { return _mm512_loadu_pd(p); }
+				NN_TARGET_AVX512 static void Store(double* p, Type v) { _mm512_storeu_pd(p, v); }
+				NN_TARGET_AVX512 static Type Set(double x) { return _mm512_set1_pd(x); }
+			};
+
+			template<> struct Avx512Vector<float>
+			{
+				typedef __m512 Type;
+				static const size_t Width = 16;
+				NN_TARGET_AVX512 static Type Load(const float* p) { return _mm512_loadu_ps(p); }
+				NN_TARGET_AVX512 static void Store(float* p, Type v) { _mm512_storeu_ps(p, v); }
+				NN_TARGET_AVX512 static Type Set(float x) { return _mm512_set1_ps(x); }
+			};
+#endif // NN_X86
+
+			struct AddOp
+			{
+				template<typename T> static T Apply(T a, T b) { return a + b; }
+#ifdef NN_X86
+				NN_TARGET_AVX2 static __m256d Apply(__m256d a, __m256d b) { return _mm256_add_pd(a, b); }
+				NN_TARGET_AVX2 static __m256 Apply(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+				NN_TARGET_AVX512 static __m512d Apply(__m512d a, __m512d b) { return _mm512_add_pd(a, b); }
+				NN_TARGET_AVX512 static __m512 Apply(__m512 a, __m512 b) { return _mm512_add_ps(a, b); }
+#endif // NN_X86
+			};
+
+			struct SubtractOp
+			{
+				template<typename T> static T Apply(T a, T b) { return a - b; }
+#ifdef NN_X86
+				NN_TARGET_AVX2 static __m256d Apply(__m256d a, __m256d b) { return _mm256_sub_pd(a, b); }
+				NN_TARGET_AVX2 static __m256 Apply(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+				NN_TARGET_AVX512 static __m512d Apply(__m512d a, __m512d b) { return _mm512_sub_pd(a, b); }
+				NN_TARGET_AVX512 static __m512 Apply(__m512 a, __m512 b) { return _mm512_sub_ps(a, b); }
+#endif // NN_X86
+			};
+
+			struct MultiplyOp
+			{
+				template<typename T> static T Apply(T a, T b) { return a * b; }
+#ifdef NN_X86
+				NN_TARGET_AVX2 static __m256d Apply(__m256d a, __m256d b) { return _mm256_mul_pd(a, b); }
+				NN_TARGET_AVX2 static __m256 Apply(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+				NN_TARGET_AVX512 static __m512d Apply(__m512d a, __m512d b) { return _mm512_mul_pd(a, b); }
+				NN_TARGET_AVX512 static __m512 Apply(__m512 a, __m512 b) { return _mm512_mul_ps(a, b); }
+#endif // NN_X86
+			};
+
+			struct DivideOp
+			{
+				template<typename T> static T Apply(T a, T b) { return a / b; }
+#ifdef NN_X86
+				NN_TARGET_AVX2 static __m256d Apply(__m256d a, __m256d b) { return _mm256_div_pd(a, b); }
+				NN_TARGET_AVX2 static __m256 Apply(__m256 a, __m256 b) { return _mm256_div_ps(a, b); }
+				NN_TARGET_AVX512 static __m512d Apply(__m512d a, __m512d b) { return _mm512_div_pd(a, b); }
+				NN_TARGET_AVX512 static __m512 Apply(__m512 a, __m512 b) { return _mm512_div_ps(a, b); }
+#endif // NN_X86
+			};
+
+			// Operands of the vector max are swapped so NaN handling matches std::max(a, b)
+			struct MaxOp
+			{
+				template<typename T> static T Apply(T a, T b) { return std::max(a, b); }
+#ifdef NN_X86
+				NN_TARGET_AVX2 static __m256d Apply(__m256d a, __m256d b) { return _mm256_max_pd(b, a); }
+				NN_TARGET_AVX2 static __m256 Apply(__m256 a, __m256 b) { return _mm256_max_ps(b, a); }
+				NN_TARGET_AVX512 static __m512d Apply(__m512d a, __m512d b) { return _mm512_max_pd(b, a); }
+				NN_TARGET_AVX512 static __m512 Apply(__m512 a, __m512 b) { return _mm512_max_ps(b, a); }
+#endif // NN_X86
+			};
+
+			struct ReverseSubtractOp
+			{
+				template<typename T> static T Apply(T a, T b) { return b - a; }
+#ifdef NN_X86
+				NN_TARGET_AVX2 static __m256d Apply(__m256d a, __m256d b) { return _mm256_sub_pd(b, a); }
+				NN_TARGET_AVX2 static __m256 Apply(__m256 a, __m256 b) { return _mm256_sub_ps(b, a); }
+				NN_TARGET_AVX512 static __m512d Apply(__m512d a, __m512d b) { return _mm512_sub_pd(b, a); }
+				NN_TARGET_AVX512 static __m512 Apply(__m512 a, __m512 b) { return _mm512_sub_ps(b, a); }
+#endif // NN_X86
+			};
+
+			template<typename Op, typename T>
+			void BinaryPortable(size_t n, const T* a, const T* b, T* out)
+			{
+				for (size_t i = 0; i < n; ++i)
+					out[i] = Op::Apply(a[i], b[i]);
+			}
+
+			template<typename Op, typename T>
+			void ScalarPortable(size_t n, const T* a, T scalar, T* out)
+			{
+				for (size_t i = 0; i < n; ++i)
+					out[i] = Op::Apply(a[i], scalar);
+			}
+
+			template<typename T>
+			void AxpyPortable(size_t n, T alpha, const T* x, T* y)
+			{
+				for (size_t i = 0; i < n; ++i)
+					y[i] += alpha * x[i];
+			}
+
+#ifdef NN_X86
+			template<typename Op, typename T>
+			NN_TARGET_AVX2 void BinaryAvx2(size_t n, const T* a, const T* b, T* out)
+			{
+				typedef Avx2Vector<T> V;
+				size_t i = 0;
+				for (; i + V::Width <= n; i += V::Width)
+					V::Store(out + i, Op::Apply(V::Load(a + i), V::Load(b + i)));
+				for (; i < n; ++i)
+					out[i] = Op::Apply(a[i], b[i]);
+			}
+
+			template<typename Op, typename T>
+			NN_TARGET_AVX2 void ScalarAvx2(size_t n, const T* a, T scalar, T* out)
+			{
+				typedef Avx2Vector<T> V;
+				const typename V::Type s = V::Set(scalar);
+				size_t i = 0;
+				for (; i + V::Width <= n; i += V::Width)
+					V::Store(out + i, Op::Apply(V::Load(a + i), s));
+				for (; i < n; ++i)
+					out[i] = Op::Apply(a[i], scalar);
+			}
+
+			template<typename T>
+			NN_TARGET_AVX2 void AxpyAvx2(size_t n, T alpha, const T* x, T* y)
+			{
+				typedef Avx2Vector<T> V;
+				const typename V::Type a = V::Set(alpha);
+				size_t i = 0;
+				for (; i + V::Width <= n; i += V::Width)
+					V::Store(y + i, AddOp::Apply(V::Load(y + i), MultiplyOp::Apply(a, V::Load(x + i))));
+				for (; i < n; ++i)
+					y[i] += alpha * x[i];
+			}
+
+			template<typename Op, typename T>
+			NN_TARGET_AVX512 void BinaryAvx512(size_t n, const T* a, const T* b, T* out)
+			{
+				typedef Avx512Vector<T> V;
+				size_t i = 0;
+				for (; i + V::Width <= n; i += V::Width)
+					V::Store(out + i, Op::Apply(V::Load(a + i), V::Load(b + i)));
+				for (; i < n; ++i)
+					out[i] = Op::Apply(a[i], b[i]);
+			}
+
+			template<typename Op, typename T>
+			NN_TARGET_AVX512 void ScalarAvx512(size_t n, const T* a, T scalar, T* out)
+			{
+				typedef Avx512Vector<T> V;
+				const typename V::Type s = V::Set(scalar);
+				size_t i = 0;
+				for (; i + V::Width <= n; i += V::Width)
+					V::Store(out + i, Op::Apply(V::Load(a + i), s));
+				for (; i < n; ++i)
+					out[i] = Op::Apply(a[i], scalar);
+			}
+
+			template<typename T>
+			NN_TARGET_AVX512 void AxpyAvx512(size_t n, T alpha, const T* x, T* y)
+			{
+				typedef Avx512Vector<T> V;
+				const typename V::Type a = V::Set(alpha);
+				size_t i = 0;
+				for (; i + V::Width <= n; i += V::Width)
+					V::Store(y + i, AddOp::Apply(V::Load(y + i), MultiplyOp::Apply(a, V::Load(x + i))));
+				for (; i < n; ++i)
+					y[i] += alpha * x[i];
+			}
+#endif // NN_X86
+
+			template<typename T>
+			struct KernelTable
+			{
+				typedef void(*BinaryKernel)(size_t, const T*, const T*, T*);
+				typedef void(*ScalarKernel)(size_t, const T*, T, T*);
+				typedef void(*AxpyKernel)(size_t, T, const T*, T*);
+				BinaryKernel Add, Subtract, Multiply, Divide, Max;
+				ScalarKernel AddScalar, MultiplyScalar, DivideScalar, ScalarSubtract;
+				AxpyKernel Axpy;
+				const char* Name;
+			};
+
+#define NN_KERNEL_TABLE(binary, scalar, axpy, name) \
+	KernelTable<T>{ binary<AddOp, T>, binary<SubtractOp, T>, binary<MultiplyOp, T>, binary<DivideOp, T>, binary<MaxOp, T>, \
+		scalar<AddOp, T>, scalar<MultiplyOp, T>, scalar<DivideOp, T>, scalar<ReverseSubtractOp, T>, axpy<T>, name }
+
+			template<typename T>
+			KernelTable<T> SelectKernels()
+			{
+#ifdef NN_X86
+				const cpu::Features& features = cpu::GetFeatures();
+				if (features.AVX512F)
+					return NN_KERNEL_TABLE(BinaryAvx512, ScalarAvx512, AxpyAvx512, "AVX-512");
+				if (features.AVX2)
+					return NN_KERNEL_TABLE(BinaryAvx2, ScalarAvx2, AxpyAvx2, "AVX2");
+#endif // NN_X86
+				return NN_KERNEL_TABLE(BinaryPortable, ScalarPortable, AxpyPortable, "Portable");
+			}
+
+#undef NN_KERNEL_TABLE
+
+			template<typename T>
+			const KernelTable<T>& Kernels()
+			{
+				static const KernelTable<T> table = SelectKernels<T>();
+				return table;
+			}
+		}
+
+		void Add(size_t n, const double* a, const double* b, double* out) { Kernels<double>().Add(n, a, b, out); }
+		void Add(size_t n, const float* a, const float* b, float* out) { Kernels<float>().Add(n, a, b, out); }
+		void Subtract(size_t n, const double* a, const double* b, double* out) { Kernels<double>().Subtract(n, a, b, out); }
+		void Subtract(size_t n, const float* a, const float* b, float* out) { Kernels<float>().Subtract(n, a, b, out); }
+		void Multiply(size_t n, const double* a, const double* b, double* out) { Kernels<double>().Multiply(n, a, b, out); }
+		void Multiply(size_t n, const float* a, const float* b, float* out) { Kernels<float>().Multiply(n, a, b, out); }
+		void Divide(size_t n, const double* a, const double* b, double* out) { Kernels<double>().Divide(n, a, b, out); }
+		void Divide(size_t n, const float* a, const float* b, float* out) { Kernels<float>().Divide(n, a, b, out); }
+		void Max(size_t n, const double* a, const double* b, double* out) { Kernels<double>().Max(n, a, b, out); }
+		void Max(size_t n, const float* a, const float* b, float* out) { Kernels<float>().Max(n, a, b, out); }
+
+		void AddScalar(size_t n, const double* a, double scalar, double* out) { Kernels<double>().AddScalar(n, a, scalar, out); }
+		void AddScalar(size_t n, const float* a, float scalar, float* out) { Kernels<float>().AddScalar(n, a, scalar, out); }
+		void MultiplyScalar(size_t n, const double* a, double scalar, double* out) { Kernels<double>().MultiplyScalar(n, a, scalar, out); }
+		void MultiplyScalar(size_t n, const float* a, float scalar, float* out) { Kernels<float>().MultiplyScalar(n, a, scalar, out); }
+		void DivideScalar(size_t n, const double* a, double scalar, double* out) { Kernels<double>().DivideScalar(n, a, scalar, out); }
+		void DivideScalar(size_t n, const float* a, float scalar, float* out) { Kernels<float>().DivideScalar(n, a, scalar, out); }
+		void ScalarSubtract(size_t n, double scalar, const double* a, double* out) { Kernels<double>().ScalarSubtract(n, a, scalar, out); }
+		void ScalarSubtract(size_t n, float scalar, const float* a, float* out) { Kernels<float>().ScalarSubtract(n, a, scalar, out); }
+
+		void Axpy(size_t n, double alpha, const double* x, double* y) { Kernels<double>().Axpy(n, alpha, x, y); }
+		void Axpy(size_t n, float alpha, const float* x, float* y) { Kernels<float>().Axpy(n, alpha, x, y); }
+
+		const char* GetInstructionSetName()
+		{
+			return Kernels<double>().Name;
+		}
+	}
+}
@@ -0,0 +1,58 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+#include <cstddef>
+
+namespace math
+{
+	// Elementwise kernels over contiguous float/double arrays
+	// The widest instruction set supported by the CPU is picked on first use, out may alias the inputs
+	namespace kernel
+	{
+		// out[i] = a[i] op b[i]
+		void Add(size_t n, const double* a, const double* b, double* out);
+		void Add(size_t n, const float* a, const float* b, float* out);
+		void Subtract(size_t n, const double* a, const double* b, double* out);
+		void Subtract(size_t n, const float* a, const float* b, float* out);
+		void Multiply(size_t n, const double* a, const double* b, double* out);
+		void Multiply(size_t n, const float* a, const float* b, float* out);
+		void Divide(size_t n, const double* a, const double* b, double* out);
+		void Divide(size_t n, const float* a, const float* b, float* out);
+		void Max(size_t n, const double* a, const double* b, double* out);
+		void Max(size_t n, const float* a, const float* b, float* out);
+
+		// out[i] = a[i] op scalar
+		void AddScalar(size_t n, const double* a, double scalar, double* out);
+		void AddScalar(size_t n, const float* a, float scalar, float* out);
+		void MultiplyScalar(size_t n, const double* a, double scalar, double* out);
+		void MultiplyScalar(size_t n, const float* a, float scalar, float* out);
+		void DivideScalar(size_t n, const double* a, double scalar, double* out);
+		void DivideScalar(size_t n, const float* a, float scalar, float* out);
+		// out[i] = scalar - a[i]
+		void ScalarSubtract(size_t n, double scalar, const double* a, double* out);
+		void ScalarSubtract(size_t n, float scalar, const float* a, float* out);
+		// y[i] += alpha * x[i]
+		void Axpy(size_t n, double alpha, const double* x, double* y);
+		void Axpy(size_t n, float alpha, const float* x, float* y);
+
+		const char* GetInstructionSetName();
+	}
+}
@@ -19,43 +19,103 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>
 */
 
 #include "Matrix.h"
+#include "Gemm.h"
+#include "Kernels.h"
+#include "VectorMath.h"
+#include "SparseMatrix.h"
 #include <random>
 #include <numeric>
 #include <functional>
 #include <cstdlib>
 
+namespace
+{
+	// Reads elements saved by a build with a different precision through a small stack buffer
+	template<typename Stored>
+	void ReadConverted(std::ifstream& infile, Scalar* destination, size_t count)
+	{
+		const size_t CHUNK = 512;
+		Stored stored[CHUNK];
+		for (size_t done = 0; done < count; done += CHUNK)
+		{
+			const size_t n = std::min(CHUNK, count - done);
+			infile.read((char*)stored, sizeof(Stored)*n);
+			std::copy(stored, stored + n, destination + done);
+		}
+	}
+
+	// Runs a kernel over the whole buffer when both operands share a layout and own their padding, which stays zero for
+	// the kernels used here, otherwise row by row over the logical columns only
+	template<typename Kernel>
+	void ApplyRows(Kernel kernel, bool wholeBuffer, unsigned int rows, unsigned int columns, Scalar* out, unsigned int outStride, const Scalar* in, unsigned int inStride)
+	{
+		if (wholeBuffer && outStride == inStride)
+			kernel((size_t)rows*outStride, out, in);
+		else
+			for (unsigned int i = 0; i < rows; ++i)
+				kernel(columns, out + (size_t)i*outStride, in + (size_t)i*inStride);
+	}
+
+	// Runs a kernel that would write non-zero padding over the logical columns of each row
+	template<typename Kernel>
+	void ApplyColumns(Kernel kernel, unsigned int rows, unsigned int columns, Scalar* data, unsigned int stride)
+	{
+		if (columns == stride)
+			kernel((size_t)rows*columns, data);
+		else
+			for (unsigned int i = 0; i < rows; ++i)
+				kernel(columns, data + (size_t)i*stride);
+	}
+
+	// Runs a kernel that keeps zero padding zero over the whole buffer when the padding is owned, else as ApplyColumns
+	template<typename Kernel>
+	void ApplyBuffer(Kernel kernel, bool wholeBuffer, unsigned int rows, unsigned int columns, Scalar* data, unsigned int stride)
+	{
+		if (wholeBuffer)
+			kernel((size_t)rows*stride, data);
+		else
+			ApplyColumns(kernel, rows, columns, data, stride);
+	}
+}
+
 #ifdef _DEBUG
 #define LOG(x) std::cout << x << std::endl
 #endif // _DEBUG
 
 
-Matrix::Matrix() : m_Rows(0), m_Columns(0), m_Matrix()
+Matrix::Matrix() : m_Rows(0), m_Columns(0), m_Stride(0), m_Matrix(), m_Data(nullptr)
+{
+}
+
+Matrix::Matrix(unsigned int rows, unsigned int columns, Scalar initValue) : Matrix(rows, columns, initValue, columns)
 {
 }
 
-Matrix::Matrix(unsigned int rows, unsigned int columns, double initValue) : m_Rows(rows), m_Columns(columns), m_Matrix(rows*columns)
+Matrix::Matrix(unsigned int rows, unsigned int columns, Scalar initValue, unsigned int stride)
+	: m_Rows(rows), m_Columns(columns), m_Stride(std::max(stride, columns)), m_Matrix((size_t)rows*std::max(stride, columns), 0), m_Data(m_Matrix.data())
 {
 	if (initValue == -1)
 		Randomize();
-	else
-		std::fill(m_Matrix.begin(), m_Matrix.end(), initValue);
+	else if (initValue != 0)
+		ApplyColumns([initValue](size_t n, Scalar* x) { std::fill(x, x + n, initValue); }, m_Rows, m_Columns, m_Data, m_Stride);
 }
 
-Matrix::Matrix(const Matrix & matrix) : m_Rows(matrix.m_Rows), m_Columns(matrix.m_Columns), m_Matrix(matrix.m_Matrix)
+Matrix::Matrix(const Matrix & matrix) : m_Rows(0), m_Columns(0), m_Stride(0), m_Matrix(), m_Data(nullptr)
 {
+	Assign(matrix);
 }
 
-Matrix::Matrix(Matrix && matrix) : m_Rows(matrix.m_Rows), m_Columns(matrix.m_Columns), m_Matrix(std::move(matrix.m_Matrix))
+Matrix::Matrix(Matrix && matrix) : m_Rows(matrix.m_Rows), m_Columns(matrix.m_Columns), m_Stride(matrix.m_Stride), m_Matrix(std::move(matrix.m_Matrix)), m_Data(matrix.m_Data)
 {
-
+	matrix.m_Data = matrix.m_Matrix.data();
 }
 
-Matrix::Matrix(const std::vector<double>& data) : m_Rows(data.size()), m_Columns(1), m_Matrix(data)
+Matrix::Matrix(const std::vector<Scalar>& data) : m_Rows(data.size()), m_Columns(1), m_Stride(1), m_Matrix(data.begin(), data.end()), m_Data(m_Matrix.data())
 {
 }
 
 #ifdef _DEBUG
-Matrix::Matrix(const std::vector<std::vector<double>>& matrix) : m_Rows(matrix.size()), m_Columns(matrix[0].size()), m_Matrix(matrix.size()*matrix[0].size())
+Matrix::Matrix(const std::vector<std::vector<Scalar>>& matrix) : m_Rows(matrix.size()), m_Columns(matrix[0].size()), m_Stride(matrix[0].size()), m_Matrix(matrix.size()*matrix[0].size()), m_Data(m_Matrix.data())
 {
 	for (unsigned int i = 0; i < m_Rows; ++i)
 	{
@@ -70,14 +130,31 @@ Matrix::Matrix(const std::vector<std::vector<double>>& matrix) : m_Rows(matrix.s
 
 Matrix & Matrix::operator=(const Matrix & matrix)
 {
-	m_Rows = matrix.m_Rows; m_Columns = matrix.m_Columns;
-	m_Matrix = matrix.m_Matrix;
+	// Copying into a matrix of the same shape keeps its storage and stride, a view keeps viewing its memory
+	if (this == &matrix)
+		return *this;
+	if (HasSameDimension(matrix))
+	{
+		if (HasSameLayout(matrix) && HasOwnPadding() && matrix.HasOwnPadding())
+			std::copy_n(matrix.m_Data, (size_t)m_Rows*m_Stride, m_Data);
+		else
+			for (unsigned int i = 0; i < m_Rows; ++i)
+				std::copy_n(matrix.m_Data + (size_t)i*matrix.m_Stride, m_Columns, m_Data + (size_t)i*m_Stride);
+		return *this;
+	}
+	Assign(matrix);
 	return *this;
 }
 
 Matrix & Matrix::operator=(Matrix && matrix)
 {
-	m_Rows = matrix.m_Rows; m_Columns = matrix.m_Columns; m_Matrix = std::move(matrix.m_Matrix);
+	// A view keeps viewing its memory when a matrix of its shape is moved into it, as for a copy
+	if (IsView() && HasSameDimension(matrix))
+		return *this = static_cast<const Matrix&>(matrix);
+	// Takes over the storage, or the memory viewed by matrix
+	m_Rows = matrix.m_Rows; m_Columns = matrix.m_Columns; m_Stride = matrix.m_Stride; m_Matrix = std::move(matrix.m_Matrix);
+	m_Data = matrix.m_Data;
+	matrix.m_Data = matrix.m_Matrix.data();
 	return *this;
 }
 
@@ -85,79 +162,94 @@ Matrix::~Matrix()
 {
 }
 
-double Matrix::Sum() const
+Scalar Matrix::Sum() const
 {
-	double sum = 0.0;
-	return std::accumulate(m_Matrix.begin(), m_Matrix.end(), sum);
+	// Owned padding is zero, so it does not change the sum
+	Scalar sum = 0.0;
+	if (HasOwnPadding())
+		return std::accumulate(m_Data, m_Data + (size_t)m_Rows*m_Stride, sum);
+	for (unsigned int i = 0; i < m_Rows; ++i)
+		sum = std::accumulate(m_Data + (size_t)i*m_Stride, m_Data + (size_t)i*m_Stride + m_Columns, sum);
+	return sum;
 }
 
-void Matrix::Randomize(double min, double max)
+void Matrix::Randomize(Scalar min, Scalar max)
 {
 
 	std::random_device randomDevice;
 	std::mt19937 engine(randomDevice());
-	std::uniform_real_distribution<double> valueDistribution(min, max);
-	for (unsigned int i = 0; i < m_Rows*m_Columns; ++i)
+	std::uniform_real_distribution<Scalar> valueDistribution(min, max);
+	for (unsigned int i = 0; i < m_Rows; ++i)
 	{
-		m_Matrix[i] = valueDistribution(engine);
+		for (unsigned int j = 0; j < m_Columns; ++j)
+		{
+			m_Data[j + i*m_Stride] = valueDistribution(engine);
+		}
 	}
 }
 
 void Matrix::ZeroOut()
 {
-	std::fill(m_Matrix.begin(), m_Matrix.end(), 0);
+	ApplyBuffer([](size_t n, Scalar* x) { std::fill(x, x + n, 0); }, HasOwnPadding(), m_Rows, m_Columns, m_Data, m_Stride);
 }
 
-std::vector<double> Matrix::GetColumnVector() const
+std::vector<Scalar> Matrix::GetColumnVector() const
 {
 #ifdef _DEBUG
 	if (m_Columns != 1)
 		throw MatrixError("Number of columns has to be 1 in order to make column vector!");
 #endif // _DEBUG
-	return m_Matrix;
+	std::vector<Scalar> column(m_Rows);
+	for (unsigned int i = 0; i < m_Rows; ++i)
+		column[i] = m_Data[i*m_Stride];
+	return column;
 }
 
 void Matrix::SaveMatrix(std::ofstream & outfile) const
 {
 	outfile.write((char*)(&m_Rows), sizeof(m_Rows));
 	outfile.write((char*)(&m_Columns), sizeof(m_Columns));
-	outfile.write((char*)&m_Matrix[0], sizeof(double)*m_Rows*m_Columns);
+	if (m_Stride == m_Columns)
+		outfile.write((char*)m_Data, sizeof(Scalar)*m_Rows*m_Columns);
+	else
+		for (unsigned int i = 0; i < m_Rows; ++i)
+			outfile.write((char*)(m_Data + (size_t)i*m_Stride), sizeof(Scalar)*m_Columns);
 }
 
-double & Matrix::operator()(unsigned int row, unsigned int column)
+Scalar & Matrix::operator()(unsigned int row, unsigned int column)
 {
 #ifdef _DEBUG
-	if ((column + row*m_Columns) >= m_Rows*m_Columns)
+	if (row >= m_Rows || column >= m_Columns)
 		throw MatrixError("Index out of range!");
 #endif // _DEBUG
-	return m_Matrix[column + row*m_Columns];
+	return m_Data[column + row*m_Stride];
 }
 
-const double & Matrix::operator()(unsigned int row, unsigned int column) const
+const Scalar & Matrix::operator()(unsigned int row, unsigned int column) const
 {
 #ifdef _DEBUG
-	if ((column + row*m_Columns) >= m_Rows*m_Columns)
+	if (row >= m_Rows || column >= m_Columns)
 		throw MatrixError("Index out of range!");
 #endif // _DEBUG
-	return m_Matrix[column + row*m_Columns];
+	return m_Data[column + row*m_Stride];
 }
 
-double & Matrix::operator[](const std::pair<unsigned int, unsigned int>& index)
+Scalar & Matrix::operator[](const std::pair<unsigned int, unsigned int>& index)
 {
 #ifdef _DEBUG
-	if ((index.second + index.first*m_Columns) >= m_Rows*m_Columns)
+	if (index.first >= m_Rows || index.second >= m_Columns)
 		throw MatrixError("Index out of range!");
 #endif // _DEBUG
-	return m_Matrix[index.second + index.first*m_Columns];
+	return m_Data[index.second + index.first*m_Stride];
 }
 
-const double & Matrix::operator[](const std::pair<unsigned int, unsigned int>& index) const
+const Scalar & Matrix::operator[](const std::pair<unsigned int, unsigned int>& index) const
 {
 #ifdef _DEBUG
-	if ((index.second + index.first*m_Columns) >= m_Rows*m_Columns)
+	if (index.first >= m_Rows || index.second >= m_Columns)
 		throw MatrixError("Index out of range!");
 #endif // _DEBUG
-	return m_Matrix[index.second + index.first*m_Columns];
+	return m_Data[index.second + index.first*m_Stride];
 }
 
 Matrix & Matrix::operator+=(const Matrix & other)
@@ -166,13 +258,14 @@ Matrix & Matrix::operator+=(const Matrix & other)
 	if (!HasSameDimension(other))
 		throw MatrixError("Matrices do not have the same dimension!");
 #endif // _DEBUG
-	std::transform(m_Matrix.begin(), m_Matrix.end(), other.m_Matrix.begin(), m_Matrix.begin(), std::plus<double>());
+	ApplyRows([](size_t n, Scalar* x, const Scalar* y) { math::kernel::Add(n, x, y, x); }, HasOwnPadding() && other.HasOwnPadding(),
+		m_Rows, m_Columns, m_Data, m_Stride, other.m_Data, other.m_Stride);
 	return *this;
 }
 
-Matrix & Matrix::operator+=(double scalar)
+Matrix & Matrix::operator+=(Scalar scalar)
 {
-	std::for_each(m_Matrix.begin(), m_Matrix.end(), [scalar](double& x) { x += scalar; });
+	ApplyColumns([scalar](size_t n, Scalar* x) { math::kernel::AddScalar(n, x, scalar, x); }, m_Rows, m_Columns, m_Data, m_Stride);
 	return *this;
 }
 
@@ -182,19 +275,20 @@ Matrix & Matrix::operator-=(const Matrix & other)
 	if (!HasSameDimension(other))
 		throw MatrixError("Matrices do not have the same dimension!");
 #endif // _DEBUG
-	std::transform(m_Matrix.begin(), m_Matrix.end(), other.m_Matrix.begin(), m_Matrix.begin(), std::minus<double>());
+	ApplyRows([](size_t n, Scalar* x, const Scalar* y) { math::kernel::Subtract(n, x, y, x); }, HasOwnPadding() && other.HasOwnPadding(),
+		m_Rows, m_Columns, m_Data, m_Stride, other.m_Data, other.m_Stride);
 	return *this;
 }
 
-Matrix & Matrix::operator-=(double scalar)
+Matrix & Matrix::operator-=(Scalar scalar)
 {
-	std::for_each(m_Matrix.begin(), m_Matrix.end(), [scalar](double& x) { x -= scalar; });
+	ApplyColumns([scalar](size_t n, Scalar* x) { math::kernel::AddScalar(n, x, -scalar, x); }, m_Rows, m_Columns, m_Data, m_Stride);
 	return *this;
 }
 
-Matrix & Matrix::operator*=(double scalar)
+Matrix & Matrix::operator*=(Scalar scalar)
 {
-	std::for_each(m_Matrix.begin(), m_Matrix.end(), [scalar](double& x) { x *= scalar; });
+	ApplyBuffer([scalar](size_t n, Scalar* x) { math::kernel::MultiplyScalar(n, x, scalar, x); }, HasOwnPadding(), m_Rows, m_Columns, m_Data, m_Stride);
 	return *this;
 }
 
@@ -208,13 +302,13 @@ Matrix & Matrix::operator*=(const Matrix & other)
 	return *this;
 }
 
-Matrix & Matrix::operator/=(double scalar)
+Matrix & Matrix::operator/=(Scalar scalar)
 {
 #ifdef _DEBUG
 	if (scalar == 0)
 		throw MatrixError("Cannot divide by zero!");
 #endif // _DEBUG
-	std::for_each(m_Matrix.begin(), m_Matrix.end(), [scalar](double& x) { x /= scalar; });
+	ApplyBuffer([scalar](size_t n, Scalar* x) { math::kernel::DivideScalar(n, x, scalar, x); }, HasOwnPadding(), m_Rows, m_Columns, m_Data, m_Stride);
 	return *this;
 }
 
@@ -224,39 +318,203 @@ Matrix & Matrix::DotProduct(const Matrix & other)
 	if (!HasSameDimension(other))
 		throw MatrixError("Matrices do not have the same dimension!");
 #endif // _DEBUG
-	std::transform(m_Matrix.begin(), m_Matrix.end(), other.m_Matrix.begin(), m_Matrix.begin(), std::multiplies<double>());
+	ApplyRows([](size_t n, Scalar* x, const Scalar* y) { math::kernel::Multiply(n, x, y, x); }, HasOwnPadding() && other.HasOwnPadding(),
+		m_Rows, m_Columns, m_Data, m_Stride, other.m_Data, other.m_Stride);
 	return *this;
 }
 
-Matrix & Matrix::Transpose()
+Matrix & Matrix::Exp()
+{
+	ApplyColumns([](size_t n, Scalar* x) { math::kernel::Exp(n, x, x); }, m_Rows, m_Columns, m_Data, m_Stride);
+	return *this;
+}
+
+Matrix & Matrix::Log()
+{
+	ApplyColumns([](size_t n, Scalar* x) { math::kernel::Log(n, x, x); }, m_Rows, m_Columns, m_Data, m_Stride);
+	return *this;
+}
+
+Matrix & Matrix::Tanh()
+{
+	ApplyColumns([](size_t n, Scalar* x) { math::kernel::Tanh(n, x, x); }, m_Rows, m_Columns, m_Data, m_Stride);
+	return *this;
+}
+
+Matrix & Matrix::Sigmoid()
+{
+	ApplyColumns([](size_t n, Scalar* x) { math::kernel::Sigmoid(n, x, x); }, m_Rows, m_Columns, m_Data, m_Stride);
+	return *this;
+}
+
+Matrix & Matrix::AddScaled(const MatrixView & x, Scalar alpha)
+{
+#ifdef _DEBUG
+	if (x.GetHeight() != m_Rows || x.GetWidth() != m_Columns)
+		throw MatrixError("Matrices do not have the same dimension!");
+#endif // _DEBUG
+	if (x.GetStride() == m_Stride && m_Columns == m_Stride)
+		math::Axpy(m_Rows*m_Columns, alpha, x.GetData(), 1, m_Data, 1);
+	else
+		for (unsigned int i = 0; i < m_Rows; ++i)
+			math::Axpy(m_Columns, alpha, x.GetData() + (size_t)i*x.GetStride(), 1, m_Data + (size_t)i*m_Stride, 1);
+	return *this;
+}
+
+Matrix & Matrix::AddToColumns(const MatrixView & column)
+{
+#ifdef _DEBUG
+	if (column.GetWidth() != 1 || column.GetHeight() != m_Rows)
+		throw MatrixError("Broadcast operand has to be a column vector matching the rows of the matrix!");
+#endif // _DEBUG
+	for (unsigned int i = 0; i < m_Rows; ++i)
+	{
+		const Scalar value = column.GetData()[(size_t)i*column.GetStride()];
+		Scalar* row = m_Data + (size_t)i*m_Stride;
+		for (unsigned int j = 0; j < m_Columns; ++j)
+			row[j] += value;
+	}
+	return *this;
+}
+
+Matrix & Matrix::AddRowSums(const MatrixView & x, Scalar alpha)
 {
-	if (m_Rows != 1 && m_Columns != 1)
+#ifdef _DEBUG
+	if (m_Columns != 1 || x.GetHeight() != m_Rows)
+		throw MatrixError("Row sums have to be accumulated into a column vector matching the rows of the operand!");
+#endif // _DEBUG
+	for (unsigned int i = 0; i < m_Rows; ++i)
 	{
-		std::vector<double> transposedMatrix(m_Rows*m_Columns);
+		const Scalar* row = x.GetData() + (size_t)i*x.GetStride();
+		m_Data[(size_t)i*m_Stride] += alpha * std::accumulate(row, row + x.GetWidth(), (Scalar)0);
+	}
+	return *this;
+}
+
+Matrix & Matrix::NormalizeColumns()
+{
+	for (unsigned int j = 0; j < m_Columns; ++j)
+	{
+		Scalar sum = 0;
+		for (unsigned int i = 0; i < m_Rows; ++i)
+			sum += m_Data[(size_t)i*m_Stride + j];
 		for (unsigned int i = 0; i < m_Rows; ++i)
+			m_Data[(size_t)i*m_Stride + j] /= sum;
+	}
+	return *this;
+}
+
+Matrix & Matrix::AddOuterProduct(const MatrixView & x, const MatrixView & y, Scalar alpha)
+{
+#ifdef _DEBUG
+	if (x.GetWidth() != 1 || y.GetWidth() != 1 || x.GetHeight() != m_Rows || y.GetHeight() != m_Columns)
+		throw MatrixError("Outer product operands have to be column vectors matching the rows and columns of the matrix!");
+#endif // _DEBUG
+	math::Ger(m_Rows, m_Columns, alpha, x.GetData(), x.GetStride(), y.GetData(), y.GetStride(), m_Data, m_Stride);
+	return *this;
+}
+
+Matrix & Matrix::AssignProduct(const MatrixView & left, const MatrixView & right)
+{
+	if (m_Rows != left.GetHeight() || m_Columns != right.GetWidth())
+		return *this = left * right;
+#ifdef _DEBUG
+	if (left.GetWidth() != right.GetHeight())
+		throw MatrixError("Number of columns of the left matrix has to match number of rows of the right matrix!");
+#endif // _DEBUG
+	math::Gemm(m_Rows, m_Columns, left.GetWidth(), 1.0, left.GetData(), left.GetStride(),
+		right.GetData(), right.GetStride(), 0.0, m_Data, m_Stride);
+	return *this;
+}
+
+Matrix & Matrix::AddMultiplyTranspose(const MatrixView & left, const MatrixView & right, Scalar alpha)
+{
+#ifdef _DEBUG
+	if (left.GetWidth() != right.GetWidth() || left.GetHeight() != m_Rows || right.GetHeight() != m_Columns)
+		throw MatrixError("Operands do not match the dimension of the accumulated product!");
+#endif // _DEBUG
+	math::Gemm(math::NO_TRANSPOSE, math::TRANSPOSE, m_Rows, m_Columns, left.GetWidth(), alpha, left.GetData(), left.GetStride(),
+		right.GetData(), right.GetStride(), (Scalar)1, m_Data, m_Stride);
+	return *this;
+}
+
+Matrix & Matrix::AddMultiply(const MatrixView & left, const SparseMatrix & right, Scalar alpha)
+{
+#ifdef _DEBUG
+	if (left.GetWidth() != right.GetHeight() || left.GetHeight() != m_Rows || right.GetWidth() != m_Columns)
+		throw MatrixError("Operands do not match the dimension of the accumulated product!");
+#endif // _DEBUG
+	const unsigned int* offsets = right.GetRowOffsets();
+	const unsigned int* columns = right.GetColumnIndices();
+	const Scalar* values = right.GetValues();
+	for (unsigned int i = 0; i < m_Rows; ++i)
+	{
+		Scalar* out = m_Data + (size_t)i*m_Stride;
+		for (unsigned int j = 0; j < right.GetHeight(); ++j)
+		{
+			const Scalar factor = alpha * left(i, j);
+			if (factor == 0)
+				continue;
+			for (unsigned int k = offsets[j]; k < offsets[j + 1]; ++k)
+				out[columns[k]] += factor * values[k];
+		}
+	}
+	return *this;
+}
+
+Matrix & Matrix::Transpose()
+{
+	// Row vectors and tight column vectors only need their shape swapped
+	if (m_Rows == 1 || (m_Columns == 1 && m_Stride == 1))
+	{
+		std::swap(m_Rows, m_Columns);
+		m_Stride = m_Columns;
+		// The elements of a view are already contiguous, it keeps viewing them
+		if (!IsView())
 		{
-			for (unsigned int j = 0; j < m_Columns; ++j)
-			{
-				transposedMatrix[i + j*m_Rows] = m_Matrix[j + i*m_Columns];
-			}
+			m_Matrix.resize((size_t)m_Rows*m_Stride);
+			m_Data = m_Matrix.data();
 		}
-		m_Matrix = std::move(transposedMatrix);
 	}
-	std::swap(m_Rows, m_Columns);
+	else
+		*this = Transpose(*this);
 	return *this;
 }
 
-Matrix Matrix::LoadMatrix(std::ifstream & infile)
+Matrix Matrix::LoadMatrix(std::ifstream & infile, unsigned int storedScalarSize)
 {
 	unsigned int rows, columns;
 	infile.read((char*)&rows, sizeof(rows));
 	infile.read((char*)&columns, sizeof(columns));
-	Matrix matrix(rows, columns);
-	double* m = new double[rows*columns];
-	infile.read((char*)m, sizeof(double)*rows*columns);
-	std::vector<double> mat(m, m + rows*columns);
-	matrix.m_Matrix = std::move(mat);
-	delete[] m;
+	if (storedScalarSize != sizeof(Scalar) && storedScalarSize != sizeof(float) && storedScalarSize != sizeof(double))
+		throw MatrixError("Unsupported scalar size in the model file!");
+	// Values are read straight into the padded rows, so only the padding has to be zero-filled
+	Matrix matrix = Uninitialized(rows, columns, PaddedStride(columns));
+	if (storedScalarSize == sizeof(Scalar) && matrix.m_Stride == columns)
+		infile.read((char*)matrix.m_Data, sizeof(Scalar)*rows*columns);
+	else
+		for (unsigned int i = 0; i < rows; ++i)
+		{
+			Scalar* row = matrix.m_Data + (size_t)i*matrix.m_Stride;
+			if (storedScalarSize == sizeof(Scalar))
+				infile.read((char*)row, sizeof(Scalar)*columns);
+			else if (storedScalarSize == sizeof(float))
+				ReadConverted<float>(infile, row, columns);
+			else
+				ReadConverted<double>(infile, row, columns);
+			std::fill(row + columns, row + matrix.m_Stride, (Scalar)0);
+		}
+	return matrix;
+}
+
+Matrix Matrix::Uninitialized(unsigned int rows, unsigned int columns, unsigned int stride)
+{
+	Matrix matrix;
+	matrix.m_Rows = rows;
+	matrix.m_Columns = columns;
+	matrix.m_Stride = std::max(stride, columns);
+	matrix.m_Matrix.resize((size_t)rows*matrix.m_Stride);
+	matrix.m_Data = matrix.m_Matrix.data();
 	return matrix;
 }
 
@@ -267,148 +525,147 @@ Matrix Matrix::OneHot(unsigned int one, unsigned int size)
 	return matrix;
 }
 
-Matrix Matrix::DotProduct(const Matrix & left, const Matrix & right)
+Matrix Matrix::View(Scalar* data, unsigned int rows, unsigned int columns, unsigned int stride)
 {
-#ifdef _DEBUG
-	if (!left.HasSameDimension(right))
-		throw MatrixError("Matrices do not have the same dimension!");
-#endif // _DEBUG
-	Matrix result(left);
-	std::transform(result.m_Matrix.begin(), result.m_Matrix.end(), right.m_Matrix.begin(), result.m_Matrix.begin(), std::multiplies<double>());
-	return result;
+	Matrix matrix;
+	matrix.m_Rows = rows; matrix.m_Columns = columns; matrix.m_Stride = std::max(stride, columns);
+	matrix.m_Data = data;
+	return matrix;
 }
 
 Matrix Matrix::Transpose(const Matrix & matrix)
 {
-	Matrix result(matrix);
-	if (matrix.m_Rows != 1 && matrix.m_Columns != 1)
+	Matrix result(matrix.m_Columns, matrix.m_Rows, 0);
+	for (unsigned int i = 0; i < matrix.m_Rows; ++i)
 	{
-		for (unsigned int i = 0; i < matrix.m_Rows; ++i)
+		for (unsigned int j = 0; j < matrix.m_Columns; ++j)
 		{
-			for (unsigned int j = 0; j < matrix.m_Columns; ++j)
-			{
-				result.m_Matrix[i + j*matrix.m_Rows] = matrix.m_Matrix[j + i*matrix.m_Columns];
-			}
+			result.m_Data[i + j*result.m_Stride] = matrix.m_Data[j + i*matrix.m_Stride];
 		}
 	}
-	std::swap(result.m_Rows, result.m_Columns);
 	return result;
 }
 
-Matrix Matrix::BuildColumnMatrix(unsigned int rows, double value)
-{
-	Matrix matrix(rows, 1);
-	std::fill(matrix.m_Matrix.begin(), matrix.m_Matrix.end(), value);
-	return matrix;
-}
-
-Matrix Matrix::Max(const Matrix & first, const Matrix & second)
+Matrix Matrix::TransposeMultiply(const MatrixView & left, const MatrixView & right)
 {
 #ifdef _DEBUG
-	if (!first.HasSameDimension(second))
-		throw MatrixError("Matrices do not have the same dimension!");
+	if (left.GetHeight() != right.GetHeight())
+		throw MatrixError("Number of rows of the left matrix has to match number of rows of the right matrix!");
 #endif // _DEBUG
-	Matrix result{ first };
-	std::transform(result.m_Matrix.begin(), result.m_Matrix.end(), second.m_Matrix.begin(), result.m_Matrix.begin(), [](double a, double b) { return std::max(a, b); });
+	Matrix result(left.GetWidth(), right.GetWidth(), 0);
+	math::Gemm(math::TRANSPOSE, math::NO_TRANSPOSE, left.GetWidth(), right.GetWidth(), left.GetHeight(), 1.0, left.GetData(), left.GetStride(),
+		right.GetData(), right.GetStride(), 0.0, result.m_Data, result.m_Stride);
 	return result;
 }
 
-bool Matrix::HasSameDimension(const Matrix & other) const
+Matrix Matrix::MultiplyTranspose(const MatrixView & left, const MatrixView & right)
 {
-	return m_Rows == other.m_Rows && m_Columns == other.m_Columns;
+#ifdef _DEBUG
+	if (left.GetWidth() != right.GetWidth())
+		throw MatrixError("Number of columns of the left matrix has to match number of columns of the right matrix!");
+#endif // _DEBUG
+	Matrix result(left.GetHeight(), right.GetHeight(), 0);
+	math::Gemm(math::NO_TRANSPOSE, math::TRANSPOSE, left.GetHeight(), right.GetHeight(), left.GetWidth(), 1.0, left.GetData(), left.GetStride(),
+		right.GetData(), right.GetStride(), 0.0, result.m_Data, result.m_Stride);
+	return result;
 }
 
-std::ostream & operator<<(std::ostream & out, const Matrix & m)
+Matrix Matrix::MultiplyTranspose(const MatrixView & left, const SparseMatrix & right)
 {
-	for (unsigned int i = 0; i < m.m_Rows; ++i)
+#ifdef _DEBUG
+	if (left.GetWidth() != right.GetWidth())
+		throw MatrixError("Matrices can not be multiplied!");
+#endif // _DEBUG
+	Matrix result(left.GetHeight(), right.GetHeight(), 0);
+	const unsigned int* offsets = right.GetRowOffsets();
+	const unsigned int* columns = right.GetColumnIndices();
+	const Scalar* values = right.GetValues();
+	for (unsigned int i = 0; i < left.GetHeight(); ++i)
 	{
-		for (unsigned int j = 0; j < m.m_Columns; ++j)
+		const Scalar* row = left.GetData() + (size_t)i*left.GetStride();
+		Scalar* out = result.m_Data + (size_t)i*result.m_Stride;
+		for (unsigned int j = 0; j < right.GetHeight(); ++j)
 		{
-			out << m.m_Matrix[j + i*m.m_Columns] << " ";
+			Scalar sum = 0;
+			for (unsigned int k = offsets[j]; k < offsets[j + 1]; ++k)
+				sum += row[columns[k]] * values[k];
+			out[j] = sum;
 		}
-		out << std::endl;
 	}
-	return out;
+	return result;
 }
 
-Matrix operator+(const Matrix & left, const Matrix & right)
+Matrix Matrix::BuildColumnMatrix(unsigned int rows, Scalar value)
 {
-#ifdef _DEBUG
-	if (!left.HasSameDimension(right))
-		throw MatrixError("Matrices do not have the same dimension!");
-#endif // _DEBUG
-	Matrix result(left);
-	std::transform(result.m_Matrix.begin(), result.m_Matrix.end(), right.m_Matrix.begin(), result.m_Matrix.begin(), std::plus<double>());
-	return result;
+	Matrix matrix(rows, 1);
+	std::fill(matrix.m_Data, matrix.m_Data + (size_t)matrix.m_Rows*matrix.m_Stride, value);
+	return matrix;
 }
 
-Matrix operator*(const Matrix & matrix, double scalar)
+unsigned int Matrix::PaddedStride(unsigned int columns)
 {
-	Matrix result(matrix);
-	std::for_each(result.m_Matrix.begin(), result.m_Matrix.end(), [scalar](double& x) { x *= scalar; });
-	return result;
+	// Rounds a row up to whole cache lines, so that every row starts on its own line
+	const unsigned int lineElements = 64 / sizeof(Scalar);
+	return columns <= 1 ? columns : (columns + lineElements - 1) / lineElements * lineElements;
 }
 
-Matrix operator*(double scalar, const Matrix & matrix)
+bool Matrix::HasSameDimension(const Matrix & other) const
 {
-	Matrix result(matrix);
-	std::for_each(result.m_Matrix.begin(), result.m_Matrix.end(), [scalar](double& x) { x *= scalar; });
-	return result;
+	return m_Rows == other.m_Rows && m_Columns == other.m_Columns;
 }
 
-Matrix operator-(const Matrix & left, const Matrix & right)
+bool Matrix::HasSameLayout(const Matrix & other) const
 {
-#ifdef _DEBUG
-	if (!left.HasSameDimension(right))
-		throw MatrixError("Matrices do not have the same dimension!");
-#endif // _DEBUG
-
-	Matrix result(left);
-	std::transform(result.m_Matrix.begin(), result.m_Matrix.end(), right.m_Matrix.begin(), result.m_Matrix.begin(), std::minus<double>());
-	return result;
+	return HasSameDimension(other) && m_Stride == other.m_Stride;
 }
 
-Matrix operator-(double scalar, const Matrix & matrix)
+bool Matrix::HasOwnPadding() const
 {
-	Matrix result(matrix.m_Rows, matrix.m_Columns);
-	result.Map([scalar](double x) { return scalar - x; });
-	return result;
+	return !IsView() || m_Stride == m_Columns;
 }
 
-Matrix operator*(const Matrix & left, const Matrix & right)
+void Matrix::Assign(const Matrix & matrix)
 {
-#ifdef _DEBUG
-	if (left.m_Columns != right.m_Rows)
-		throw MatrixError("Number of columns of the left matrix has to match number of rows of the right matrix!");
-#endif // _DEBUG
+	m_Rows = matrix.m_Rows; m_Columns = matrix.m_Columns; m_Stride = matrix.m_Stride;
+	if (matrix.HasOwnPadding())
+		m_Matrix.assign(matrix.m_Data, matrix.m_Data + (size_t)m_Rows*m_Stride);
+	else
+	{
+		m_Matrix.assign((size_t)m_Rows*m_Stride, 0);
+		for (unsigned int i = 0; i < m_Rows; ++i)
+			std::copy_n(matrix.m_Data + (size_t)i*m_Stride, m_Columns, m_Matrix.data() + (size_t)i*m_Stride);
+	}
+	m_Data = m_Matrix.data();
+}
 
-	Matrix result(left.m_Rows, right.m_Columns, 0);
-	for (unsigned int i = 0; i < left.m_Rows; ++i)
-		for (unsigned int k = 0; k < left.m_Columns; ++k)
-			for (unsigned int j = 0; j < right.m_Columns; ++j)
-				result(i, j) += left(i, k) * right(k, j);
-	return result;
+std::ostream & operator<<(std::ostream & out, const Matrix & m)
+{
+	for (unsigned int i = 0; i < m.m_Rows; ++i)
+	{
+		for (unsigned int j = 0; j < m.m_Columns; ++j)
+		{
+			out << m.m_Data[j + i*m.m_Stride] << " ";
+		}
+		out << std::endl;
+	}
+	return out;
 }
 
-Matrix operator/(const Matrix & matrix, double scalar)
+Matrix operator*(const MatrixView & left, const MatrixView & right)
 {
 #ifdef _DEBUG
-	if (scalar == 0)
-		throw MatrixError("Cannot divide by zero!");
+	if (left.GetWidth() != right.GetHeight())
+		throw MatrixError("Number of columns of the left matrix has to match number of rows of the right matrix!");
 #endif // _DEBUG
 
-	Matrix result(matrix);
-	std::for_each(result.m_Matrix.begin(), result.m_Matrix.end(), [scalar](double& x) { x /= scalar; });
+	Matrix result(left.GetHeight(), right.GetWidth(), 0);
+	math::Gemm(left.GetHeight(), right.GetWidth(), left.GetWidth(), 1.0, left.GetData(), left.GetStride(),
+		right.GetData(), right.GetStride(), 0.0, result.GetData(), result.GetStride());
 	return result;
 }
 
-Matrix operator/(const Matrix & left, const Matrix & right)
+void math::CheckSameDimension(unsigned int leftRows, unsigned int leftColumns, unsigned int rightRows, unsigned int rightColumns)
 {
-#ifdef _DEBUG
-	if (!left.HasSameDimension(right))
+	if (leftRows != rightRows || leftColumns != rightColumns)
 		throw MatrixError("Matrices do not have the same dimension!");
-#endif // _DEBUG
-	Matrix result{ left };
-	std::transform(result.m_Matrix.begin(), result.m_Matrix.end(), right.m_Matrix.begin(), result.m_Matrix.begin(), std::divides<double>());
-	return result;
 }
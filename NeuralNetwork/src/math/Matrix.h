@@ -23,89 +23,274 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>
 #include <algorithm>
 #include <iostream>
 #include <fstream>
+#include "Scalar.h"
+#include "MatrixExpression.h"
+#include "MatrixView.h"
+#include "Workspace.h"
+
+class SparseMatrix;
 
 struct MatrixError : std::runtime_error
 {
 	MatrixError(const char* error) : std::runtime_error(error) {}
 };
 
-class Matrix
+// Row-major storage, 64-byte aligned, with consecutive rows m_Stride elements apart
+// The padding after the last column of each row is always kept at zero, except in a view, whose padding is memory it does not own
+class Matrix : public math::MatrixExpression<Matrix>
 {
 private:
 	unsigned int m_Rows;
 	unsigned int m_Columns;
-	std::vector<double> m_Matrix;
+	unsigned int m_Stride;
+	std::vector<Scalar, math::WorkspaceAllocator<Scalar>> m_Matrix;
+	// The elements, in m_Matrix or in the external memory of a view
+	Scalar* m_Data;
 public:
 	Matrix();
-	Matrix(unsigned int rows, unsigned int columns, double initValue = -1);
+	Matrix(unsigned int rows, unsigned int columns, Scalar initValue = -1);
+	Matrix(unsigned int rows, unsigned int columns, Scalar initValue, unsigned int stride);
 	Matrix(const Matrix& matrix);
 	Matrix(Matrix&& matrix);
-	Matrix(const std::vector<double>& data);
+	Matrix(const std::vector<Scalar>& data);
+	template<typename E> Matrix(const math::MatrixExpression<E>& expression);
 #ifdef _DEBUG
-	Matrix(const std::vector<std::vector<double>>& matrix);
+	Matrix(const std::vector<std::vector<Scalar>>& matrix);
 #endif // _DEBUG
 	Matrix& operator=(const Matrix& matrix);
 	Matrix& operator=(Matrix&& matrix);
+	template<typename E> Matrix& operator=(const math::MatrixExpression<E>& expression);
 	~Matrix();
 
 	inline unsigned int GetWidth() const { return m_Columns; }
 	inline unsigned int GetHeight() const { return m_Rows; }
+	inline unsigned int GetStride() const { return m_Stride; }
+	inline Scalar* GetData() { return m_Data; }
+	inline const Scalar* GetData() const { return m_Data; }
+	inline Scalar At(unsigned int row, unsigned int column) const { return m_Data[(size_t)row*m_Stride + column]; }
+	inline bool IsView() const { return m_Data != m_Matrix.data(); }
 
-	double Sum() const;
-	void Randomize(double min = -1, double max = 1);
+	Scalar Sum() const;
+	void Randomize(Scalar min = -1, Scalar max = 1);
 	void ZeroOut();
-	std::vector<double> GetColumnVector() const;
+	std::vector<Scalar> GetColumnVector() const;
 	void SaveMatrix(std::ofstream& outfile) const;
 
-	inline double& operator()(unsigned int row, unsigned int column);
-	inline const double& operator()(unsigned int row, unsigned int column) const;
-	inline double& operator[](const std::pair<unsigned int, unsigned int>& index);
-	inline const double& operator[](const std::pair<unsigned int, unsigned int>& index) const;
+	inline Scalar& operator()(unsigned int row, unsigned int column);
+	inline const Scalar& operator()(unsigned int row, unsigned int column) const;
+	inline Scalar& operator[](const std::pair<unsigned int, unsigned int>& index);
+	inline const Scalar& operator[](const std::pair<unsigned int, unsigned int>& index) const;
 
 	Matrix& operator +=(const Matrix& other);
-	Matrix& operator +=(double scalar);
+	Matrix& operator +=(Scalar scalar);
 	Matrix& operator -=(const Matrix& other);
-	Matrix& operator -=(double scalar);
-	Matrix& operator *=(double scalar);
+	Matrix& operator -=(Scalar scalar);
+	template<typename E> Matrix& operator +=(const math::MatrixExpression<E>& expression);
+	template<typename E> Matrix& operator -=(const math::MatrixExpression<E>& expression);
+	// this += x * alpha and this -= x * alpha as one AXPY per row
+	Matrix& operator +=(const math::MapExpression<Matrix, math::op::MultiplyBy>& expression);
+	Matrix& operator -=(const math::MapExpression<Matrix, math::op::MultiplyBy>& expression);
+	Matrix& operator *=(Scalar scalar);
 	Matrix& operator *= (const Matrix& other);
-	Matrix& operator /= (double scalar);
+	Matrix& operator /= (Scalar scalar);
 	Matrix& DotProduct(const Matrix& other);
+	// In place this += alpha * x, one AXPY per row
+	Matrix& AddScaled(const MatrixView& x, Scalar alpha);
+	// In place adds a column vector to every column, broadcasts a bias over a batch of samples
+	Matrix& AddToColumns(const MatrixView& column);
+	// In place this += alpha * (sum of the columns of x), reduces a batch of column vectors to one
+	Matrix& AddRowSums(const MatrixView& x, Scalar alpha = 1);
+	// Divides every column by its sum
+	Matrix& NormalizeColumns();
+	// In place this += alpha * x * y^T for column vectors x and y, without forming the outer product
+	Matrix& AddOuterProduct(const MatrixView& x, const MatrixView& y, Scalar alpha = 1);
+	// this = left * right, the storage is reused when it already has the shape of the product, neither operand may be this
+	Matrix& AssignProduct(const MatrixView& left, const MatrixView& right);
+	// In place this += alpha * left * right^T, the rank-k form of AddOuterProduct
+	Matrix& AddMultiplyTranspose(const MatrixView& left, const MatrixView& right, Scalar alpha = 1);
+	// In place this += alpha * left * right, only the columns that hold entries of the sparse right are touched
+	Matrix& AddMultiply(const MatrixView& left, const SparseMatrix& right, Scalar alpha = 1);
 	Matrix& Transpose();
 	template<typename _Func> Matrix& Map(_Func&& func);
+	// Elementwise in place through the vectorized kernels, accuracy follows math::SetAccuracy
+	Matrix& Exp();
+	Matrix& Log();
+	Matrix& Tanh();
+	Matrix& Sigmoid();
 
 	friend std::ostream& operator << (std::ostream& out, const Matrix& m);
 
-	friend Matrix operator+(const Matrix& left, const Matrix& right);
-	friend Matrix operator*(const Matrix& matrix, double scalar);
-	friend Matrix operator*(double scalar, const Matrix& matrix);
-	friend Matrix operator-(const Matrix& left, const Matrix& right);
-	friend Matrix operator-(double scalar, const Matrix& matrix);
-	friend Matrix operator*(const Matrix& left, const Matrix& right);
-	friend Matrix operator/(const Matrix& matrix, double scalar);
-	friend Matrix operator/(const Matrix& left, const Matrix& right);
-
-	static Matrix LoadMatrix(std::ifstream& infile);
+	// Reads a matrix written by SaveMatrix into cache-line padded rows
+	static Matrix LoadMatrix(std::ifstream& infile, unsigned int storedScalarSize = sizeof(Scalar));
 	static Matrix OneHot(unsigned int one, unsigned int size);
-	static Matrix DotProduct(const Matrix& left, const Matrix& right);
+	// Writable matrix over rows*stride elements of external memory, which must outlive it
+	// Operations that keep the shape write through to the memory and leave the elements between rows alone
+	// A matrix of the same shape copied or moved into a view is written through, one of another shape replaces the view, a copy of a view owns its storage
+	static Matrix View(Scalar* data, unsigned int rows, unsigned int columns, unsigned int stride);
+	template<typename L, typename R>
+	static math::BinaryExpression<L, R, math::op::Multiply> DotProduct(const math::MatrixExpression<L>& left, const math::MatrixExpression<R>& right);
 	static Matrix Transpose(const Matrix& matrix);
-	static Matrix BuildColumnMatrix(unsigned int rows, double value);
-	static Matrix Max(const Matrix& first, const Matrix& second);
-	template<typename _Func> static Matrix Map(const Matrix& matrix, _Func&& func);
+	static Matrix TransposeMultiply(const MatrixView& left, const MatrixView& right);
+	static Matrix MultiplyTranspose(const MatrixView& left, const MatrixView& right);
+	// left * right^T with the rows of the sparse right as columns of the result, a SpMV for one row and a SpMM for several
+	static Matrix MultiplyTranspose(const MatrixView& left, const SparseMatrix& right);
+	static Matrix BuildColumnMatrix(unsigned int rows, Scalar value);
+	static unsigned int PaddedStride(unsigned int columns);
+	// Storage is left uninitialised, the caller has to write every element and the padding
+	static Matrix Uninitialized(unsigned int rows, unsigned int columns, unsigned int stride);
+	template<typename L, typename R>
+	static math::BinaryExpression<L, R, math::op::Max> Max(const math::MatrixExpression<L>& first, const math::MatrixExpression<R>& second);
+	template<typename E, typename _Func>
+	static math::MapExpression<E, typename std::decay<_Func>::type> Map(const math::MatrixExpression<E>& matrix, _Func&& func);
 private:
 	bool HasSameDimension(const Matrix& other) const;
+	bool HasSameLayout(const Matrix& other) const;
+	// Whether kernels may run over the padding as well, true unless a view has elements between its rows
+	bool HasOwnPadding() const;
+	// Copies matrix into storage of its own with the same stride
+	void Assign(const Matrix& matrix);
+	// Gives the matrix the shape of an expression, a matrix that already has it keeps its storage and stride
+	void Reshape(unsigned int rows, unsigned int columns);
+	template<typename E> void Evaluate(const math::MatrixExpression<E>& expression);
+	// A single operation on whole matrices runs a row at a time through the vectorized kernels
+	template<typename Op> void Evaluate(const math::BinaryExpression<Matrix, Matrix, Op>& expression);
+	template<typename Func> void Evaluate(const math::MapExpression<Matrix, Func>& expression);
 };
 
+// Matrix product, either operand may be a Matrix or a view
+Matrix operator*(const MatrixView& left, const MatrixView& right);
+
+inline MatrixView::MatrixView(const Matrix& matrix)
+	: m_Data(matrix.GetData()), m_Rows(matrix.GetHeight()), m_Columns(matrix.GetWidth()), m_Stride(matrix.GetStride())
+{
+}
+
+template<typename E>
+inline Matrix::Matrix(const math::MatrixExpression<E>& expression) : m_Rows(0), m_Columns(0), m_Stride(0), m_Matrix(), m_Data(nullptr)
+{
+	Evaluate(expression.Derived());
+}
+
+template<typename E>
+inline Matrix & Matrix::operator=(const math::MatrixExpression<E>& expression)
+{
+	Evaluate(expression.Derived());
+	return *this;
+}
+
+template<typename E>
+inline Matrix & Matrix::operator+=(const math::MatrixExpression<E>& expression)
+{
+#ifdef _DEBUG
+	math::CheckSameDimension(m_Rows, m_Columns, expression.GetHeight(), expression.GetWidth());
+#endif // _DEBUG
+	for (unsigned int i = 0; i < m_Rows; ++i)
+	{
+		Scalar* row = m_Data + (size_t)i*m_Stride;
+		for (unsigned int j = 0; j < m_Columns; ++j)
+			row[j] += expression.At(i, j);
+	}
+	return *this;
+}
+
+template<typename E>
+inline Matrix & Matrix::operator-=(const math::MatrixExpression<E>& expression)
+{
+#ifdef _DEBUG
+	math::CheckSameDimension(m_Rows, m_Columns, expression.GetHeight(), expression.GetWidth());
+#endif // _DEBUG
+	for (unsigned int i = 0; i < m_Rows; ++i)
+	{
+		Scalar* row = m_Data + (size_t)i*m_Stride;
+		for (unsigned int j = 0; j < m_Columns; ++j)
+			row[j] -= expression.At(i, j);
+	}
+	return *this;
+}
+
+inline Matrix & Matrix::operator+=(const math::MapExpression<Matrix, math::op::MultiplyBy>& expression)
+{
+	return AddScaled(expression.GetExpression(), expression.GetFunc().Value);
+}
+
+inline Matrix & Matrix::operator-=(const math::MapExpression<Matrix, math::op::MultiplyBy>& expression)
+{
+	return AddScaled(expression.GetExpression(), -expression.GetFunc().Value);
+}
+
+inline void Matrix::Reshape(unsigned int rows, unsigned int columns)
+{
+	if (m_Rows != rows || m_Columns != columns)
+	{
+		m_Rows = rows; m_Columns = columns; m_Stride = m_Columns;
+		m_Matrix.resize((size_t)m_Rows*m_Stride);
+		m_Data = m_Matrix.data();
+	}
+}
+
+// Evaluation is purely elementwise, so the expression may safely refer to this matrix
+template<typename E>
+inline void Matrix::Evaluate(const math::MatrixExpression<E>& expression)
+{
+	Reshape(expression.GetHeight(), expression.GetWidth());
+	for (unsigned int i = 0; i < m_Rows; ++i)
+	{
+		Scalar* row = m_Data + (size_t)i*m_Stride;
+		for (unsigned int j = 0; j < m_Columns; ++j)
+			row[j] = expression.At(i, j);
+	}
+}
+
+template<typename Op>
+inline void Matrix::Evaluate(const math::BinaryExpression<Matrix, Matrix, Op>& expression)
+{
+	const Matrix& left = expression.GetLeft();
+	const Matrix& right = expression.GetRight();
+	Reshape(left.m_Rows, left.m_Columns);
+	if (m_Stride == m_Columns && left.m_Stride == m_Columns && right.m_Stride == m_Columns)
+		Op::Apply((size_t)m_Rows*m_Columns, left.m_Data, right.m_Data, m_Data);
+	else
+		for (unsigned int i = 0; i < m_Rows; ++i)
+			Op::Apply(m_Columns, left.m_Data + (size_t)i*left.m_Stride, right.m_Data + (size_t)i*right.m_Stride, m_Data + (size_t)i*m_Stride);
+}
+
+template<typename Func>
+inline void Matrix::Evaluate(const math::MapExpression<Matrix, Func>& expression)
+{
+	const Matrix& matrix = expression.GetExpression();
+	Reshape(matrix.m_Rows, matrix.m_Columns);
+	if (m_Stride == m_Columns && matrix.m_Stride == m_Columns)
+		math::MapRow(expression.GetFunc(), (size_t)m_Rows*m_Columns, matrix.m_Data, m_Data);
+	else
+		for (unsigned int i = 0; i < m_Rows; ++i)
+			math::MapRow(expression.GetFunc(), m_Columns, matrix.m_Data + (size_t)i*matrix.m_Stride, m_Data + (size_t)i*m_Stride);
+}
+
 template<typename _Func>
 inline Matrix & Matrix::Map(_Func&& func)
 {
-	std::for_each(m_Matrix.begin(), m_Matrix.end(), [&func](double& x) { x = func(x); });
+	for (unsigned int i = 0; i < m_Rows; ++i)
+	{
+		Scalar* row = m_Data + (size_t)i*m_Stride;
+		std::for_each(row, row + m_Columns, [&func](Scalar& x) { x = func(x); });
+	}
 	return *this;
 }
 
-template<typename _Func>
-inline Matrix Matrix::Map(const Matrix & matrix, _Func&& func)
+template<typename L, typename R>
+inline math::BinaryExpression<L, R, math::op::Multiply> Matrix::DotProduct(const math::MatrixExpression<L>& left, const math::MatrixExpression<R>& right)
+{
+	return math::BinaryExpression<L, R, math::op::Multiply>(left.Derived(), right.Derived());
+}
+
+template<typename L, typename R>
+inline math::BinaryExpression<L, R, math::op::Max> Matrix::Max(const math::MatrixExpression<L>& first, const math::MatrixExpression<R>& second)
+{
+	return math::BinaryExpression<L, R, math::op::Max>(first.Derived(), second.Derived());
+}
+
+template<typename E, typename _Func>
+inline math::MapExpression<E, typename std::decay<_Func>::type> Matrix::Map(const math::MatrixExpression<E>& matrix, _Func&& func)
 {
-	Matrix result = matrix;
-	result.Map(func);
-	return result;
+	return math::MapExpression<E, typename std::decay<_Func>::type>(matrix.Derived(), std::forward<_Func>(func));
 }
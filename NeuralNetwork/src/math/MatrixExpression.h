@@ -0,0 +1,200 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+#include "Scalar.h"
+#include "Kernels.h"
+
+class Matrix;
+
+namespace math
+{
+	// Elementwise Matrix arithmetic builds these lightweight expression objects instead of temporaries
+	// The whole chain is evaluated in a single pass when it is assigned to (or accumulated into) a Matrix
+	// Matrices are captured by reference, so an expression must not outlive the statement that creates it
+	template<typename E>
+	class MatrixExpression
+	{
+	public:
+		inline const E& Derived() const { return static_cast<const E&>(*this); }
+		inline unsigned int GetWidth() const { return Derived().GetWidth(); }
+		inline unsigned int GetHeight() const { return Derived().GetHeight(); }
+		inline Scalar At(unsigned int row, unsigned int column) const { return Derived().At(row, column); }
+		Scalar Sum() const
+		{
+			Scalar sum = 0;
+			for (unsigned int i = 0; i < GetHeight(); ++i)
+				for (unsigned int j = 0; j < GetWidth(); ++j)
+					sum += At(i, j);
+			return sum;
+		}
+	};
+
+	// Throws MatrixError in debug builds when the operands of an elementwise operation differ in shape
+	void CheckSameDimension(unsigned int leftRows, unsigned int leftColumns, unsigned int rightRows, unsigned int rightColumns);
+
+	template<typename E> struct ExpressionOperand { typedef const E Type; };
+	template<> struct ExpressionOperand<Matrix> { typedef const Matrix& Type; };
+
+	template<typename L, typename R, typename Op>
+	class BinaryExpression : public MatrixExpression<BinaryExpression<L, R, Op>>
+	{
+	private:
+		typename ExpressionOperand<L>::Type m_Left;
+		typename ExpressionOperand<R>::Type m_Right;
+	public:
+		BinaryExpression(const L& left, const R& right) : m_Left(left), m_Right(right)
+		{
+#ifdef _DEBUG
+			CheckSameDimension(left.GetHeight(), left.GetWidth(), right.GetHeight(), right.GetWidth());
+#endif // _DEBUG
+		}
+		inline unsigned int GetWidth() const { return m_Left.GetWidth(); }
+		inline unsigned int GetHeight() const { return m_Left.GetHeight(); }
+		inline Scalar At(unsigned int row, unsigned int column) const { return Op::Apply(m_Left.At(row, column), m_Right.At(row, column)); }
+		inline const L& GetLeft() const { return m_Left; }
+		inline const R& GetRight() const { return m_Right; }
+	};
+
+	template<typename E, typename Func>
+	class MapExpression : public MatrixExpression<MapExpression<E, Func>>
+	{
+	private:
+		typename ExpressionOperand<E>::Type m_Expression;
+		Func m_Func;
+	public:
+		MapExpression(const E& expression, Func func) : m_Expression(expression), m_Func(std::move(func)) {}
+		inline unsigned int GetWidth() const { return m_Expression.GetWidth(); }
+		inline unsigned int GetHeight() const { return m_Expression.GetHeight(); }
+		inline Scalar At(unsigned int row, unsigned int column) const { return (Scalar)m_Func(m_Expression.At(row, column)); }
+		inline const E& GetExpression() const { return m_Expression; }
+		inline const Func& GetFunc() const { return m_Func; }
+	};
+
+	// Every operation also applies to n contiguous elements at once through its vectorized kernel
+	namespace op
+	{
+		struct Add
+		{
+			static inline Scalar Apply(Scalar a, Scalar b) { return a + b; }
+			static inline void Apply(size_t n, const Scalar* a, const Scalar* b, Scalar* out) { kernel::Add(n, a, b, out); }
+		};
+
+		struct Subtract
+		{
+			static inline Scalar Apply(Scalar a, Scalar b) { return a - b; }
+			static inline void Apply(size_t n, const Scalar* a, const Scalar* b, Scalar* out) { kernel::Subtract(n, a, b, out); }
+		};
+
+		struct Multiply
+		{
+			static inline Scalar Apply(Scalar a, Scalar b) { return a * b; }
+			static inline void Apply(size_t n, const Scalar* a, const Scalar* b, Scalar* out) { kernel::Multiply(n, a, b, out); }
+		};
+
+		struct Divide
+		{
+			static inline Scalar Apply(Scalar a, Scalar b) { return a / b; }
+			static inline void Apply(size_t n, const Scalar* a, const Scalar* b, Scalar* out) { kernel::Divide(n, a, b, out); }
+		};
+
+		struct Max
+		{
+			static inline Scalar Apply(Scalar a, Scalar b) { return std::max(a, b); }
+			static inline void Apply(size_t n, const Scalar* a, const Scalar* b, Scalar* out) { kernel::Max(n, a, b, out); }
+		};
+
+		struct MultiplyBy
+		{
+			Scalar Value;
+			inline Scalar operator()(Scalar x) const { return x * Value; }
+		};
+
+		struct DivideBy
+		{
+			Scalar Value;
+			inline Scalar operator()(Scalar x) const { return x / Value; }
+		};
+
+		struct SubtractFrom
+		{
+			Scalar Value;
+			inline Scalar operator()(Scalar x) const { return Value - x; }
+		};
+	}
+
+	// out[i] = func(x[i]) over n contiguous elements, the scalar operations above go through their kernels
+	template<typename Func>
+	inline void MapRow(const Func& func, size_t n, const Scalar* x, Scalar* out)
+	{
+		for (size_t i = 0; i < n; ++i)
+			out[i] = (Scalar)func(x[i]);
+	}
+
+	inline void MapRow(const op::MultiplyBy& func, size_t n, const Scalar* x, Scalar* out) { kernel::MultiplyScalar(n, x, func.Value, out); }
+	inline void MapRow(const op::DivideBy& func, size_t n, const Scalar* x, Scalar* out) { kernel::DivideScalar(n, x, func.Value, out); }
+	inline void MapRow(const op::SubtractFrom& func, size_t n, const Scalar* x, Scalar* out) { kernel::ScalarSubtract(n, func.Value, x, out); }
+
+	template<typename L, typename R>
+	inline BinaryExpression<L, R, op::Add> operator+(const MatrixExpression<L>& left, const MatrixExpression<R>& right)
+	{
+		return BinaryExpression<L, R, op::Add>(left.Derived(), right.Derived());
+	}
+
+	template<typename L, typename R>
+	inline BinaryExpression<L, R, op::Subtract> operator-(const MatrixExpression<L>& left, const MatrixExpression<R>& right)
+	{
+		return BinaryExpression<L, R, op::Subtract>(left.Derived(), right.Derived());
+	}
+
+	template<typename L, typename R>
+	inline BinaryExpression<L, R, op::Divide> operator/(const MatrixExpression<L>& left, const MatrixExpression<R>& right)
+	{
+		return BinaryExpression<L, R, op::Divide>(left.Derived(), right.Derived());
+	}
+
+	template<typename E>
+	inline MapExpression<E, op::MultiplyBy> operator*(const MatrixExpression<E>& matrix, Scalar scalar)
+	{
+		return MapExpression<E, op::MultiplyBy>(matrix.Derived(), op::MultiplyBy{ scalar });
+	}
+
+	template<typename E>
+	inline MapExpression<E, op::MultiplyBy> operator*(Scalar scalar, const MatrixExpression<E>& matrix)
+	{
+		return MapExpression<E, op::MultiplyBy>(matrix.Derived(), op::MultiplyBy{ scalar });
+	}
+
+	template<typename E>
+	inline MapExpression<E, op::DivideBy> operator/(const MatrixExpression<E>& matrix, Scalar scalar)
+	{
+		return MapExpression<E, op::DivideBy>(matrix.Derived(), op::DivideBy{ scalar });
+	}
+
+	template<typename E>
+	inline MapExpression<E, op::SubtractFrom> operator-(Scalar scalar, const MatrixExpression<E>& matrix)
+	{
+		return MapExpression<E, op::SubtractFrom>(matrix.Derived(), op::SubtractFrom{ scalar });
+	}
+}
@@ -0,0 +1,54 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+#include <vector>
+#include "Scalar.h"
+#include "MatrixExpression.h"
+
+// Non-owning, read-only window onto row-major memory: a Matrix, a slice of one, an input vector or an external buffer
+// The viewed memory must outlive the view
+class MatrixView : public math::MatrixExpression<MatrixView>
+{
+private:
+	const Scalar* m_Data;
+	unsigned int m_Rows;
+	unsigned int m_Columns;
+	unsigned int m_Stride;
+public:
+	MatrixView(const Scalar* data, unsigned int rows, unsigned int columns) : m_Data(data), m_Rows(rows), m_Columns(columns), m_Stride(columns) {}
+	MatrixView(const Scalar* data, unsigned int rows, unsigned int columns, unsigned int stride) : m_Data(data), m_Rows(rows), m_Columns(columns), m_Stride(stride) {}
+	MatrixView(const std::vector<Scalar>& column) : m_Data(column.data()), m_Rows((unsigned int)column.size()), m_Columns(1), m_Stride(1) {}
+	MatrixView(const Matrix& matrix);
+
+	inline unsigned int GetWidth() const { return m_Columns; }
+	inline unsigned int GetHeight() const { return m_Rows; }
+	inline unsigned int GetStride() const { return m_Stride; }
+	inline const Scalar* GetData() const { return m_Data; }
+	inline Scalar At(unsigned int row, unsigned int column) const { return m_Data[(size_t)row*m_Stride + column]; }
+	inline const Scalar& operator()(unsigned int row, unsigned int column) const { return m_Data[(size_t)row*m_Stride + column]; }
+
+	inline MatrixView Block(unsigned int row, unsigned int column, unsigned int rows, unsigned int columns) const
+	{
+		return MatrixView(m_Data + (size_t)row*m_Stride + column, rows, columns, m_Stride);
+	}
+	inline MatrixView Row(unsigned int row) const { return Block(row, 0, 1, m_Columns); }
+	inline MatrixView Column(unsigned int column) const { return Block(0, column, m_Rows, 1); }
+};
@@ -0,0 +1,249 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "QuantizedMatrix.h"
+#include "Cpu.h"
+#include "ThreadPool.h"
+#include <cmath>
+
+#ifdef NN_X86
+#include <immintrin.h>
+#endif // NN_X86
+
+namespace
+{
+	// Activations use 7 bits so that vpmaddubsw can not saturate its 16-bit pair sums
+	const int ACTIVATION_MAX = 127;
+	// Below this many multiply-adds waking the thread pool costs more than it saves
+	const unsigned long long PARALLEL_THRESHOLD = 1024 * 1024;
+
+	typedef int32_t(*DotKernel)(size_t, const uint8_t*, const int8_t*);
+
+	// Every kernel takes n as a multiple of 64
+	int32_t DotPortable(size_t n, const uint8_t* a, const int8_t* b)
+	{
+		int32_t sum = 0;
+		for (size_t i = 0; i < n; ++i)
+			sum += (int32_t)a[i] * b[i];
+		return sum;
+	}
+
+#ifdef NN_X86
+	// vpmaddubsw multiplies unsigned by signed bytes into 16-bit pair sums, vpmaddwd widens them to 32 bits
+	NN_TARGET_AVX2 int32_t DotAvx2(size_t n, const uint8_t* a, const int8_t* b)
+	{
+		const __m256i ones = _mm256_set1_epi16(1);
+		__m256i acc = _mm256_setzero_si256();
+		for (size_t i = 0; i < n; i += 32)
+		{
+			__m256i products = _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(a + i)), _mm256_loadu_si256((const __m256i*)(b + i)));
+			acc = _mm256_add_epi32(acc, _mm256_madd_epi16(products, ones));
+		}
+		__m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+		return _mm_cvtsi128_si32(sum);
+	}
+
+	// vpdpbusd does the whole unsigned x signed byte dot product into 32 bits in one instruction
+	NN_TARGET_AVX512VNNI int32_t DotVnni(size_t n, const uint8_t* a, const int8_t* b)
+	{
+		__m512i acc = _mm512_setzero_si512();
+		for (size_t i = 0; i < n; i += 64)
+			acc = _mm512_dpbusd_epi32(acc, _mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i));
+		return _mm512_reduce_add_epi32(acc);
+	}
+#endif // NN_X86
+
+	struct KernelTable
+	{
+		std::vector<const char*> Names;
+		std::vector<DotKernel> Kernels;
+	};
+
+	// Slowest first, so that the last kernel is the one to use
+	KernelTable SelectKernels()
+	{
+		KernelTable table;
+		table.Names.push_back("Portable");
+		table.Kernels.push_back(DotPortable);
+#ifdef NN_X86
+		const math::cpu::Features& features = math::cpu::GetFeatures();
+		if (features.AVX2)
+		{
+			table.Names.push_back("AVX2");
+			table.Kernels.push_back(DotAvx2);
+		}
+		if (features.AVX512VNNI)
+		{
+			table.Names.push_back("AVX-512 VNNI");
+			table.Kernels.push_back(DotVnni);
+		}
+#endif // NN_X86
+		return table;
+	}
+
+	const KernelTable& GetKernels()
+	{
+		static const KernelTable table = SelectKernels();
+		return table;
+	}
+
+	unsigned int PaddedBytes(unsigned int columns)
+	{
+		return (columns + 63) / 64 * 64;
+	}
+
+	// Scale and zero point mapping [min(values, 0), max(values, 0)] onto [low, high], so that zero stays exact
+	template<typename Iterator>
+	void ChooseQuantization(Iterator begin, Iterator end, int low, int high, Scalar& scale, int32_t& zeroPoint)
+	{
+		Scalar minimum = 0, maximum = 0;
+		for (Iterator it = begin; it != end; ++it)
+		{
+			minimum = std::min(minimum, (Scalar)*it);
+			maximum = std::max(maximum, (Scalar)*it);
+		}
+		scale = (maximum - minimum) / (high - low);
+		if (scale == 0)
+			scale = 1;
+		zeroPoint = (int32_t)std::min<Scalar>(high, std::max<Scalar>(low, std::nearbyint(low - minimum / scale)));
+	}
+
+	inline int32_t Quantize(Scalar value, Scalar scale, int32_t zeroPoint, int low, int high)
+	{
+		return (int32_t)std::min<Scalar>(high, std::max<Scalar>(low, std::nearbyint(value / scale) + zeroPoint));
+	}
+}
+
+QuantizedMatrix::QuantizedMatrix() : m_Rows(0), m_Columns(0), m_Stride(0)
+{
+}
+
+QuantizedMatrix::QuantizedMatrix(const MatrixView & matrix) : m_Rows(matrix.GetHeight()), m_Columns(matrix.GetWidth()), m_Stride(PaddedBytes(matrix.GetWidth())),
+	m_Data((size_t)m_Rows*m_Stride, 0), m_Scales(m_Rows), m_ZeroPoints(m_Rows), m_RowSums(m_Rows, 0)
+{
+	for (unsigned int i = 0; i < m_Rows; ++i)
+	{
+		const Scalar* row = matrix.GetData() + (size_t)i*matrix.GetStride();
+		ChooseQuantization(row, row + m_Columns, -128, 127, m_Scales[i], m_ZeroPoints[i]);
+		int8_t* quantized = m_Data.data() + (size_t)i*m_Stride;
+		for (unsigned int j = 0; j < m_Columns; ++j)
+		{
+			quantized[j] = (int8_t)Quantize(row[j], m_Scales[i], m_ZeroPoints[i], -128, 127);
+			m_RowSums[i] += quantized[j];
+		}
+	}
+}
+
+size_t QuantizedMatrix::GetMemorySize() const
+{
+	return m_Data.size() * sizeof(int8_t) + m_Rows * (sizeof(Scalar) + 2 * sizeof(int32_t));
+}
+
+Matrix QuantizedMatrix::Dequantize() const
+{
+	Matrix matrix(m_Rows, m_Columns, 0);
+	for (unsigned int i = 0; i < m_Rows; ++i)
+	{
+		const int8_t* quantized = m_Data.data() + (size_t)i*m_Stride;
+		Scalar* row = matrix.GetData() + (size_t)i*matrix.GetStride();
+		for (unsigned int j = 0; j < m_Columns; ++j)
+			row[j] = m_Scales[i] * (quantized[j] - m_ZeroPoints[i]);
+	}
+	return matrix;
+}
+
+const std::vector<const char*>& QuantizedMatrix::GetKernelNames()
+{
+	return GetKernels().Names;
+}
+
+Matrix QuantizedMatrix::Multiply(const MatrixView & right, unsigned int kernel) const
+{
+	return MultiplyWith(right, GetKernels().Kernels.at(kernel));
+}
+
+Matrix operator*(const QuantizedMatrix & left, const MatrixView & right)
+{
+	return left.MultiplyWith(right, GetKernels().Kernels.back());
+}
+
+Matrix QuantizedMatrix::MultiplyWith(const MatrixView & right, DotKernel dot) const
+{
+#ifdef _DEBUG
+	if (m_Columns != right.GetHeight())
+		throw MatrixError("Matrices can not be multiplied!");
+#endif // _DEBUG
+	const unsigned int rows = m_Rows, columns = right.GetWidth(), depth = m_Columns, stride = m_Stride;
+	Matrix result(rows, columns, 0);
+	// Activations are quantized column by column into zero-padded rows matching the weight stride
+	std::vector<uint8_t, math::WorkspaceAllocator<uint8_t>> activations((size_t)columns*stride, 0);
+	std::vector<Scalar> activationScales(columns);
+	std::vector<int32_t> activationZeroPoints(columns), activationSums(columns, 0);
+	for (unsigned int c = 0; c < columns; ++c)
+	{
+		MatrixView column = right.Column(c);
+		Scalar minimum = 0, maximum = 0;
+		for (unsigned int p = 0; p < depth; ++p)
+		{
+			minimum = std::min(minimum, column(p, 0));
+			maximum = std::max(maximum, column(p, 0));
+		}
+		const Scalar bounds[] = { minimum, maximum };
+		ChooseQuantization(bounds, bounds + 2, 0, ACTIVATION_MAX, activationScales[c], activationZeroPoints[c]);
+		uint8_t* quantized = activations.data() + (size_t)c*stride;
+		for (unsigned int p = 0; p < depth; ++p)
+		{
+			quantized[p] = (uint8_t)Quantize(column(p, 0), activationScales[c], activationZeroPoints[c], 0, ACTIVATION_MAX);
+			activationSums[c] += quantized[p];
+		}
+	}
+	// Requantization: sum((qa - za) * (qw - zw)) = dot - za * sum(qw) - zw * sum(qa) + depth * za * zw
+	auto multiplyRows = [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; ++i)
+		{
+			const int8_t* weights = m_Data.data() + (size_t)i*stride;
+			const long long zw = m_ZeroPoints[i];
+			Scalar* out = result.GetData() + (size_t)i*result.GetStride();
+			for (unsigned int c = 0; c < columns; ++c)
+			{
+				const long long za = activationZeroPoints[c];
+				long long accumulator = dot(stride, activations.data() + (size_t)c*stride, weights)
+					- za * m_RowSums[i] - zw * activationSums[c] + (long long)depth * za * zw;
+				out[c] = m_Scales[i] * activationScales[c] * (Scalar)accumulator;
+			}
+		}
+	};
+	math::ThreadPool& pool = math::ThreadPool::GetInstance();
+	if ((unsigned long long)rows*stride*columns >= PARALLEL_THRESHOLD && pool.GetThreadCount() > 1)
+	{
+		unsigned int bands = std::min(pool.GetThreadCount(), rows);
+		unsigned int bandHeight = (rows + bands - 1) / bands;
+		pool.ParallelFor(bands, [&](unsigned int band)
+		{
+			multiplyRows(std::min(rows, band*bandHeight), std::min(rows, (band + 1)*bandHeight));
+		});
+	}
+	else
+		multiplyRows(0, rows);
+	return result;
+}
@@ -0,0 +1,68 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "Matrix.h"
+
+// Inference-only int8 copy of a weight matrix, 8x smaller than double storage
+// Each row is quantized asymmetrically: w ~ Scale * (q - ZeroPoint), with q in [-128, 127]
+// Rows are padded with zeros to whole cache lines so the dot-product kernels never handle a tail
+class QuantizedMatrix
+{
+private:
+	unsigned int m_Rows;
+	unsigned int m_Columns;
+	unsigned int m_Stride;
+	std::vector<int8_t, math::WorkspaceAllocator<int8_t>> m_Data;
+	std::vector<Scalar> m_Scales;
+	std::vector<int32_t> m_ZeroPoints;
+	// Sum of the quantized values of each row, folds the activation zero point out of the dot products
+	std::vector<int32_t> m_RowSums;
+
+	typedef int32_t(*DotKernel)(size_t, const uint8_t*, const int8_t*);
+	Matrix MultiplyWith(const MatrixView& right, DotKernel dot) const;
+public:
+	QuantizedMatrix();
+	explicit QuantizedMatrix(const MatrixView& matrix);
+
+	inline unsigned int GetWidth() const { return m_Columns; }
+	inline unsigned int GetHeight() const { return m_Rows; }
+	inline unsigned int GetStride() const { return m_Stride; }
+	inline const int8_t* GetData() const { return m_Data.data(); }
+	inline Scalar GetScale(unsigned int row) const { return m_Scales[row]; }
+	inline int32_t GetZeroPoint(unsigned int row) const { return m_ZeroPoints[row]; }
+	// Bytes held by the quantized values and the per-row parameters
+	size_t GetMemorySize() const;
+
+	Matrix Dequantize() const;
+	// Instruction sets of the dot-product kernels the CPU can run, operator* uses the last one
+	static const std::vector<const char*>& GetKernelNames();
+	// operator* with the kernel GetKernelNames()[kernel], every kernel gives the same result
+	Matrix Multiply(const MatrixView& right, unsigned int kernel) const;
+
+	friend Matrix operator*(const QuantizedMatrix& left, const MatrixView& right);
+};
+
+// Quantized GEMV per column of right, GEMM for several columns
+// Each column is quantized on the fly to 7-bit unsigned values with its own scale and zero point,
+// multiplied with int8 x uint8 -> int32 dot products and requantized to Scalar with the row and column scales
+Matrix operator*(const QuantizedMatrix& left, const MatrixView& right);
@@ -0,0 +1,136 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "SparseMatrix.h"
+#include <algorithm>
+#include <numeric>
+
+SparseMatrix::SparseMatrix() : m_Rows(0), m_Columns(0), m_RowOffsets(1, 0)
+{
+}
+
+SparseMatrix::SparseMatrix(unsigned int rows, unsigned int columns, std::vector<unsigned int> rowOffsets, std::vector<unsigned int> columnIndices, std::vector<Scalar> values)
+	: m_Rows(rows), m_Columns(columns), m_RowOffsets(std::move(rowOffsets)), m_ColumnIndices(std::move(columnIndices)), m_Values(std::move(values))
+{
+#ifdef _DEBUG
+	if (m_RowOffsets.size() != (size_t)rows + 1 || m_RowOffsets.front() != 0 || m_RowOffsets.back() != m_Values.size() || m_ColumnIndices.size() != m_Values.size())
+		throw MatrixError("Row offsets, column indices and values do not describe a CSR matrix!");
+	for (unsigned int i = 0; i < rows; ++i)
+		for (unsigned int k = m_RowOffsets[i]; k < m_RowOffsets[i + 1]; ++k)
+			if (m_ColumnIndices[k] >= columns || (k > m_RowOffsets[i] && m_ColumnIndices[k] <= m_ColumnIndices[k - 1]))
+				throw MatrixError("Column indices have to be in range and ascending within a row!");
+#endif // _DEBUG
+}
+
+Matrix SparseMatrix::ToDense() const
+{
+	Matrix dense(m_Rows, m_Columns, 0);
+	for (unsigned int i = 0; i < m_Rows; ++i)
+		for (unsigned int k = m_RowOffsets[i]; k < m_RowOffsets[i + 1]; ++k)
+			dense.GetData()[(size_t)i*dense.GetStride() + m_ColumnIndices[k]] = m_Values[k];
+	return dense;
+}
+
+void SparseMatrix::AppendRows(const SparseMatrix & rows)
+{
+	if (m_Rows == 0)
+		m_Columns = rows.m_Columns;
+#ifdef _DEBUG
+	if (rows.m_Columns != m_Columns)
+		throw MatrixError("Appended rows do not have the same width!");
+#endif // _DEBUG
+	const unsigned int offset = (unsigned int)m_Values.size();
+	for (unsigned int i = 1; i <= rows.m_Rows; ++i)
+		m_RowOffsets.push_back(offset + rows.m_RowOffsets[i]);
+	m_ColumnIndices.insert(m_ColumnIndices.end(), rows.m_ColumnIndices.begin(), rows.m_ColumnIndices.end());
+	m_Values.insert(m_Values.end(), rows.m_Values.begin(), rows.m_Values.end());
+	m_Rows += rows.m_Rows;
+}
+
+void SparseMatrix::Clear()
+{
+	m_Rows = 0;
+	m_Columns = 0;
+	m_RowOffsets.assign(1, 0);
+	m_ColumnIndices.clear();
+	m_Values.clear();
+}
+
+SparseMatrix SparseMatrix::FromTriplets(unsigned int rows, unsigned int columns, const std::vector<unsigned int>& rowIndices,
+	const std::vector<unsigned int>& columnIndices, const std::vector<Scalar>& values)
+{
+#ifdef _DEBUG
+	if (rowIndices.size() != values.size() || columnIndices.size() != values.size())
+		throw MatrixError("Every triplet needs a row, a column and a value!");
+	for (size_t k = 0; k < values.size(); ++k)
+		if (rowIndices[k] >= rows || columnIndices[k] >= columns)
+			throw MatrixError("Triplet coordinates are out of range!");
+#endif // _DEBUG
+	std::vector<size_t> order(values.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&rowIndices, &columnIndices](size_t a, size_t b)
+	{
+		return rowIndices[a] != rowIndices[b] ? rowIndices[a] < rowIndices[b] : columnIndices[a] < columnIndices[b];
+	});
+	std::vector<unsigned int> rowOffsets(rows + 1, 0);
+	std::vector<unsigned int> compressedColumns;
+	std::vector<Scalar> compressedValues;
+	compressedColumns.reserve(values.size());
+	compressedValues.reserve(values.size());
+	for (size_t k = 0; k < order.size(); ++k)
+	{
+		size_t index = order[k];
+		if (k > 0 && rowIndices[index] == rowIndices[order[k - 1]] && columnIndices[index] == columnIndices[order[k - 1]])
+		{
+			compressedValues.back() += values[index];
+			continue;
+		}
+		rowOffsets[rowIndices[index] + 1]++;
+		compressedColumns.push_back(columnIndices[index]);
+		compressedValues.push_back(values[index]);
+	}
+	std::partial_sum(rowOffsets.begin(), rowOffsets.end(), rowOffsets.begin());
+	return SparseMatrix(rows, columns, std::move(rowOffsets), std::move(compressedColumns), std::move(compressedValues));
+}
+
+SparseMatrix SparseMatrix::BuildRowVector(unsigned int size, const std::vector<unsigned int>& indices, const std::vector<Scalar>& values)
+{
+	return FromTriplets(1, size, std::vector<unsigned int>(indices.size(), 0), indices, values);
+}
+
+SparseMatrix SparseMatrix::FromDense(const MatrixView& matrix)
+{
+	std::vector<unsigned int> rowOffsets(matrix.GetHeight() + 1, 0);
+	std::vector<unsigned int> columnIndices;
+	std::vector<Scalar> values;
+	for (unsigned int i = 0; i < matrix.GetHeight(); ++i)
+	{
+		for (unsigned int j = 0; j < matrix.GetWidth(); ++j)
+		{
+			if (matrix(i, j) != 0)
+			{
+				columnIndices.push_back(j);
+				values.push_back(matrix(i, j));
+			}
+		}
+		rowOffsets[i + 1] = (unsigned int)values.size();
+	}
+	return SparseMatrix(matrix.GetHeight(), matrix.GetWidth(), std::move(rowOffsets), std::move(columnIndices), std::move(values));
+}
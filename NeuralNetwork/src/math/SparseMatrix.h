@@ -0,0 +1,59 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+#include <vector>
+#include "Matrix.h"
+
+// Compressed sparse row storage: row i holds the entries [RowOffsets[i], RowOffsets[i + 1]) of ColumnIndices and Values
+// Column indices are ascending and unique within a row, explicit zeros are allowed
+// Samples are stored as rows, so a single sparse input is a 1 x inputSize matrix and a batch is batchSize x inputSize
+class SparseMatrix
+{
+private:
+	unsigned int m_Rows;
+	unsigned int m_Columns;
+	std::vector<unsigned int> m_RowOffsets;
+	std::vector<unsigned int> m_ColumnIndices;
+	std::vector<Scalar> m_Values;
+public:
+	SparseMatrix();
+	SparseMatrix(unsigned int rows, unsigned int columns, std::vector<unsigned int> rowOffsets, std::vector<unsigned int> columnIndices, std::vector<Scalar> values);
+
+	inline unsigned int GetWidth() const { return m_Columns; }
+	inline unsigned int GetHeight() const { return m_Rows; }
+	inline unsigned int GetNonZeroCount() const { return (unsigned int)m_Values.size(); }
+	inline const unsigned int* GetRowOffsets() const { return m_RowOffsets.data(); }
+	inline const unsigned int* GetColumnIndices() const { return m_ColumnIndices.data(); }
+	inline const Scalar* GetValues() const { return m_Values.data(); }
+
+	Matrix ToDense() const;
+	// Appends the rows of a matrix with the same width, an empty matrix takes the width of the first rows appended
+	void AppendRows(const SparseMatrix& rows);
+	// Leaves an empty matrix that keeps its storage for the rows appended next
+	void Clear();
+
+	// COO triplets in any order, duplicate coordinates are summed
+	static SparseMatrix FromTriplets(unsigned int rows, unsigned int columns, const std::vector<unsigned int>& rowIndices,
+		const std::vector<unsigned int>& columnIndices, const std::vector<Scalar>& values);
+	// One sample of the given width from the indices of its nonzero features and their values
+	static SparseMatrix BuildRowVector(unsigned int size, const std::vector<unsigned int>& indices, const std::vector<Scalar>& values);
+	static SparseMatrix FromDense(const MatrixView& matrix);
+};
@@ -0,0 +1,127 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace math
+{
+	namespace
+	{
+		thread_local bool insideTask = false;
+
+		// Marks the thread as running tasks until it leaves the scope, also when a task throws
+		struct TaskScope
+		{
+			TaskScope() { insideTask = true; }
+			~TaskScope() { insideTask = false; }
+		};
+	}
+
+	ThreadPool & ThreadPool::GetInstance()
+	{
+		// Never destroyed, joining threads from static destructors can deadlock when the library is unloaded
+		static ThreadPool* pool = new ThreadPool(std::max(1u, std::thread::hardware_concurrency()));
+		return *pool;
+	}
+
+	ThreadPool::ThreadPool(unsigned int threadCount)
+		: m_Task(nullptr), m_TaskCount(0), m_NextTask(0), m_BusyWorkers(0), m_Generation(0)
+	{
+		for (unsigned int i = 1; i < threadCount; ++i)
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+
+	unsigned int ThreadPool::GetThreadCount() const
+	{
+		return (unsigned int)m_Workers.size() + 1;
+	}
+
+	void ThreadPool::Run(unsigned int count, const std::function<void(unsigned int)>& task)
+	{
+		if (count == 0)
+			return;
+		if (count == 1 || m_Workers.empty() || insideTask)
+		{
+			for (unsigned int i = 0; i < count; ++i)
+				task(i);
+			return;
+		}
+		std::lock_guard<std::mutex> submitLock(m_SubmitMutex);
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Task = &task;
+			m_TaskCount = count;
+			m_NextTask = 0;
+			m_Generation++;
+		}
+		m_WorkAvailable.notify_all();
+		RunTasks(task, count);
+		// Workers that picked the loop up may still be finishing their last task
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_WorkDone.wait(lock, [this] { return m_BusyWorkers == 0; });
+		m_Task = nullptr;
+		m_TaskCount = 0;
+		std::exception_ptr error = m_Error;
+		m_Error = nullptr;
+		lock.unlock();
+		if (error != nullptr)
+			std::rethrow_exception(error);
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		unsigned long long seenGeneration = 0;
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		while (true)
+		{
+			m_WorkAvailable.wait(lock, [this, &seenGeneration] { return m_Generation != seenGeneration; });
+			seenGeneration = m_Generation;
+			if (m_Task == nullptr)
+				continue;
+			const std::function<void(unsigned int)>& task = *m_Task;
+			unsigned int count = m_TaskCount;
+			m_BusyWorkers++;
+			lock.unlock();
+			RunTasks(task, count);
+			lock.lock();
+			if (--m_BusyWorkers == 0)
+				m_WorkDone.notify_all();
+		}
+	}
+
+	void ThreadPool::RunTasks(const std::function<void(unsigned int)>& task, unsigned int count)
+	{
+		TaskScope scope;
+		try
+		{
+			for (unsigned int i = m_NextTask++; i < count; i = m_NextTask++)
+				task(i);
+		}
+		catch (...)
+		{
+			// The first exception is rethrown by ParallelFor once every thread is done, the tasks nobody started are skipped
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_Error == nullptr)
+				m_Error = std::current_exception();
+			m_NextTask = count;
+		}
+	}
+}
@@ -0,0 +1,65 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <functional>
+
+namespace math
+{
+	// Process-wide pool of worker threads shared by the parallel math routines
+	// One parallel loop runs at a time, loops started from inside a task run on the calling thread
+	class ThreadPool
+	{
+	private:
+		std::vector<std::thread> m_Workers;
+		std::mutex m_SubmitMutex;
+		std::mutex m_Mutex;
+		std::condition_variable m_WorkAvailable;
+		std::condition_variable m_WorkDone;
+		const std::function<void(unsigned int)>* m_Task;
+		unsigned int m_TaskCount;
+		std::atomic<unsigned int> m_NextTask;
+		unsigned int m_BusyWorkers;
+		unsigned long long m_Generation;
+		std::exception_ptr m_Error;
+	public:
+		static ThreadPool& GetInstance();
+		// Number of threads a parallel loop is spread over, including the calling thread
+		unsigned int GetThreadCount() const;
+		// Calls task(i) for every i in [0, count) and returns once all of them have finished
+		// When a task throws, the tasks not yet started are skipped and the first exception is rethrown here
+		// The task is wrapped by reference, so starting a loop does not allocate whatever its lambda captures
+		template<typename Task>
+		void ParallelFor(unsigned int count, const Task& task) { Run(count, std::function<void(unsigned int)>(std::cref(task))); }
+	private:
+		ThreadPool(unsigned int threadCount);
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		void Run(unsigned int count, const std::function<void(unsigned int)>& task);
+		void WorkerLoop();
+		void RunTasks(const std::function<void(unsigned int)>& task, unsigned int count);
+	};
+}
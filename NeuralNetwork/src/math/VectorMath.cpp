@@ -0,0 +1,380 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "VectorMath.h"
+#include "Cpu.h"
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#ifdef NN_X86
+#include <immintrin.h>
+#endif // NN_X86
+
+namespace math
+{
+	namespace
+	{
+		std::atomic<int> accuracy(FAST);
+	}
+
+	void SetAccuracy(Accuracy value)
+	{
+		accuracy.store(value, std::memory_order_relaxed);
+	}
+
+	Accuracy GetAccuracy()
+	{
+		return static_cast<Accuracy>(accuracy.load(std::memory_order_relaxed));
+	}
+
+	namespace kernel
+	{
+		namespace
+		{
+			template<typename T>
+			void ExpExact(size_t n, const T* a, T* out)
+			{
+				for (size_t i = 0; i < n; ++i)
+					out[i] = std::exp(a[i]);
+			}
+
+			template<typename T>
+			void LogExact(size_t n, const T* a, T* out)
+			{
+				for (size_t i = 0; i < n; ++i)
+					out[i] = std::log(a[i]);
+			}
+
+			template<typename T>
+			void TanhExact(size_t n, const T* a, T* out)
+			{
+				for (size_t i = 0; i < n; ++i)
+					out[i] = std::tanh(a[i]);
+			}
+
+			template<typename T>
+			void SigmoidExact(size_t n, const T* a, T* out)
+			{
+				for (size_t i = 0; i < n; ++i)
+					out[i] = 1 / (1 + std::exp(-a[i]));
+			}
+
+#ifdef NN_X86
+			// exp(x) = 2^k * exp(r) with |r| <= ln(2) / 2, exp(r) - 1 comes from its Taylor polynomial
+			// log(x) = e * ln(2) + log(m) with m in [sqrt(2) / 2, sqrt(2)], log(m) = 2 * atanh((m - 1) / (m + 1)) from its series
+			// Both truncations stay far below half an ulp, the bound is set by the rounding of the evaluation
+			template<typename T> struct Constants;
+
+			template<> struct Constants<double>
+			{
+				static constexpr double Log2E = 1.4426950408889634;
+				static constexpr double Ln2High = 6.93147180369123816490e-01;
+				static constexpr double Ln2Low = 1.90821492927058770002e-10;
+				// Beyond these exp overflows to infinity or rounds to zero, below 2^-1075 = half the smallest subnormal
+				static constexpr double ExpMax = 709.782712893384;
+				static constexpr double ExpMin = -745.1332191019412;
+				// tanh rounds to +-1 past this
+				static constexpr double TanhMax = 19.1;
+				static constexpr double MinNormal = 2.2250738585072014e-308;
+				static constexpr double SubnormalScale = 18014398509481984.0;
+				static constexpr double SubnormalExponent = 54;
+				static constexpr double Sqrt2 = 1.4142135623730951;
+				static constexpr double ExpPolynomial[] = { 1.0 / 6227020800, 1.0 / 479001600, 1.0 / 39916800, 1.0 / 3628800, 1.0 / 362880,
+					1.0 / 40320, 1.0 / 5040, 1.0 / 720, 1.0 / 120, 1.0 / 24, 1.0 / 6, 1.0 / 2 };
+				static constexpr double LogPolynomial[] = { 2.0 / 23, 2.0 / 21, 2.0 / 19, 2.0 / 17, 2.0 / 15, 2.0 / 13,
+					2.0 / 11, 2.0 / 9, 2.0 / 7, 2.0 / 5, 2.0 / 3 };
+			};
+
+			template<> struct Constants<float>
+			{
+				static constexpr float Log2E = 1.44269504f;
+				static constexpr float Ln2High = 0.693359375f;
+				static constexpr float Ln2Low = -2.12194440e-4f;
+				static constexpr float ExpMax = 88.7228317f;
+				static constexpr float ExpMin = -103.972077f;
+				static constexpr float TanhMax = 9.1f;
+				static constexpr float MinNormal = 1.17549435e-38f;
+				static constexpr float SubnormalScale = 33554432.0f;
+				static constexpr float SubnormalExponent = 25;
+				static constexpr float Sqrt2 = 1.41421356f;
+				static constexpr float ExpPolynomial[] = { 1.0f / 5040, 1.0f / 720, 1.0f / 120, 1.0f / 24, 1.0f / 6, 1.0f / 2 };
+				static constexpr float LogPolynomial[] = { 2.0f / 11, 2.0f / 9, 2.0f / 7, 2.0f / 5, 2.0f / 3 };
+			};
+
+			constexpr double Constants<double>::ExpPolynomial[];
+			constexpr double Constants<double>::LogPolynomial[];
+			constexpr float Constants<float>::ExpPolynomial[];
+			constexpr float Constants<float>::LogPolynomial[];
+
+			template<typename T> struct Avx2Math;
+
+			template<> struct Avx2Math<double>
+			{
+				typedef __m256d Type;
+				static const size_t Width = 4;
+				NN_TARGET_AVX2 static Type Load(const double* p) { return _mm256_loadu_pd(p); }
+				NN_TARGET_AVX2 static void Store(double* p, Type v) { _mm256_storeu_pd(p, v); }
+				NN_TARGET_AVX2 static Type Set(double x) { return _mm256_set1_pd(x); }
+				NN_TARGET_AVX2 static Type Add(Type a, Type b) { return _mm256_add_pd(a, b); }
+				NN_TARGET_AVX2 static Type Subtract(Type a, Type b) { return _mm256_sub_pd(a, b); }
+				NN_TARGET_AVX2 static Type Multiply(Type a, Type b) { return _mm256_mul_pd(a, b); }
+				NN_TARGET_AVX2 static Type Divide(Type a, Type b) { return _mm256_div_pd(a, b); }
+				NN_TARGET_AVX2 static Type MultiplyAdd(Type a, Type b, Type c) { return _mm256_fmadd_pd(a, b, c); }
+				NN_TARGET_AVX2 static Type Min(Type a, Type b) { return _mm256_min_pd(a, b); }
+				NN_TARGET_AVX2 static Type Max(Type a, Type b) { return _mm256_max_pd(a, b); }
+				NN_TARGET_AVX2 static Type Round(Type a) { return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+				NN_TARGET_AVX2 static Type Less(Type a, Type b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+				NN_TARGET_AVX2 static Type Greater(Type a, Type b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+				NN_TARGET_AVX2 static Type Equal(Type a, Type b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+				NN_TARGET_AVX2 static Type IsNaN(Type a) { return _mm256_cmp_pd(a, a, _CMP_UNORD_Q); }
+				// mask ? a : b
+				NN_TARGET_AVX2 static Type Select(Type mask, Type a, Type b) { return _mm256_blendv_pd(b, a, mask); }
+				NN_TARGET_AVX2 static Type Abs(Type a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+				NN_TARGET_AVX2 static Type CopySign(Type magnitude, Type sign)
+				{
+					const __m256d mask = _mm256_set1_pd(-0.0);
+					return _mm256_or_pd(_mm256_andnot_pd(mask, magnitude), _mm256_and_pd(mask, sign));
+				}
+				// 2^k for integral k in [-1022, 1023], built in the exponent field; adding 2^52 leaves k + 1023 in the low mantissa bits
+				NN_TARGET_AVX2 static Type Pow2(Type k)
+				{
+					const __m256i biased = _mm256_castpd_si256(_mm256_add_pd(k, _mm256_set1_pd(4503599627370496.0 + 1023)));
+					return _mm256_castsi256_pd(_mm256_slli_epi64(biased, 52));
+				}
+				// Splits a positive normal x into its unbiased exponent and a mantissa in [1, 2)
+				NN_TARGET_AVX2 static Type Exponent(Type x, Type& mantissa)
+				{
+					const __m256i bits = _mm256_castpd_si256(x);
+					mantissa = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFll)),
+						_mm256_set1_epi64x(0x3FF0000000000000ll)));
+					const __m256i exponent = _mm256_or_si256(_mm256_srli_epi64(bits, 52), _mm256_castpd_si256(_mm256_set1_pd(4503599627370496.0)));
+					return _mm256_sub_pd(_mm256_castsi256_pd(exponent), _mm256_set1_pd(4503599627370496.0 + 1023));
+				}
+			};
+
+			template<> struct Avx2Math<float>
+			{
+				typedef __m256 Type;
+				static const size_t Width = 8;
+				NN_TARGET_AVX2 static Type Load(const float* p) { return _mm256_loadu_ps(p); }
+				NN_TARGET_AVX2 static void Store(float* p, Type v) { _mm256_storeu_ps(p, v); }
+				NN_TARGET_AVX2 static Type Set(float x) { return _mm256_set1_ps(x); }
+				NN_TARGET_AVX2 static Type Add(Type a, Type b) { return _mm256_add_ps(a, b); }
+				NN_TARGET_AVX2 static Type Subtract(Type a, Type b) { return _mm256_sub_ps(a, b); }
+				NN_TARGET_AVX2 static Type Multiply(Type a, Type b) { return _mm256_mul_ps(a, b); }
+				NN_TARGET_AVX2 static Type Divide(Type a, Type b) { return _mm256_div_ps(a, b); }
+				NN_TARGET_AVX2 static Type MultiplyAdd(Type a, Type b, Type c) { return _mm256_fmadd_ps(a, b, c); }
+				NN_TARGET_AVX2 static Type Min(Type a, Type b) { return _mm256_min_ps(a, b); }
+				NN_TARGET_AVX2 static Type Max(Type a, Type b) { return _mm256_max_ps(a, b); }
+				NN_TARGET_AVX2 static Type Round(Type a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+				NN_TARGET_AVX2 static Type Less(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+				NN_TARGET_AVX2 static Type Greater(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+				NN_TARGET_AVX2 static Type Equal(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+				NN_TARGET_AVX2 static Type IsNaN(Type a) { return _mm256_cmp_ps(a, a, _CMP_UNORD_Q); }
+				NN_TARGET_AVX2 static Type Select(Type mask, Type a, Type b) { return _mm256_blendv_ps(b, a, mask); }
+				NN_TARGET_AVX2 static Type Abs(Type a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+				NN_TARGET_AVX2 static Type CopySign(Type magnitude, Type sign)
+				{
+					const __m256 mask = _mm256_set1_ps(-0.0f);
+					return _mm256_or_ps(_mm256_andnot_ps(mask, magnitude), _mm256_and_ps(mask, sign));
+				}
+				// 2^k for integral k in [-126, 127]
+				NN_TARGET_AVX2 static Type Pow2(Type k)
+				{
+					const __m256i biased = _mm256_add_epi32(_mm256_cvtps_epi32(k), _mm256_set1_epi32(127));
+					return _mm256_castsi256_ps(_mm256_slli_epi32(biased, 23));
+				}
+				NN_TARGET_AVX2 static Type Exponent(Type x, Type& mantissa)
+				{
+					const __m256i bits = _mm256_castps_si256(x);
+					mantissa = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F800000)));
+					return _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+				}
+			};
+
+			// Horner evaluation, coefficients from the highest degree down
+			template<typename T, size_t N>
+			NN_TARGET_AVX2 typename Avx2Math<T>::Type Polynomial(typename Avx2Math<T>::Type x, const T(&coefficients)[N])
+			{
+				typedef Avx2Math<T> V;
+				typename V::Type p = V::Set(coefficients[0]);
+				for (size_t i = 1; i < N; ++i)
+					p = V::MultiplyAdd(p, x, V::Set(coefficients[i]));
+				return p;
+			}
+
+			// Reduces x to k * ln(2) + r and returns exp(r) - 1, x must already be clamped
+			template<typename T>
+			NN_TARGET_AVX2 typename Avx2Math<T>::Type ReducedExpM1(typename Avx2Math<T>::Type x, typename Avx2Math<T>::Type& k)
+			{
+				typedef Avx2Math<T> V;
+				typedef Constants<T> C;
+				k = V::Round(V::Multiply(x, V::Set(C::Log2E)));
+				typename V::Type r = V::MultiplyAdd(k, V::Set(-C::Ln2High), x);
+				r = V::MultiplyAdd(k, V::Set(-C::Ln2Low), r);
+				return V::MultiplyAdd(Polynomial<T>(r, C::ExpPolynomial), V::Multiply(r, r), r);
+			}
+
+			template<typename T>
+			NN_TARGET_AVX2 typename Avx2Math<T>::Type ExpFast(typename Avx2Math<T>::Type x)
+			{
+				typedef Avx2Math<T> V;
+				typedef Constants<T> C;
+				const typename V::Type clamped = V::Min(V::Max(x, V::Set(C::ExpMin)), V::Set(C::ExpMax));
+				typename V::Type k;
+				const typename V::Type expM1 = ReducedExpM1<T>(clamped, k);
+				// k may fall below the smallest normal exponent or reach one past the largest, so 2^k is applied as 2^h * 2^(k - h)
+				// with both halves normal; only the last multiplication rounds, which gives correctly rounded subnormal results
+				const typename V::Type h = V::Round(V::Multiply(k, V::Set(static_cast<T>(0.5))));
+				typename V::Type result = V::Multiply(V::Multiply(V::Add(expM1, V::Set(1)), V::Pow2(h)), V::Pow2(V::Subtract(k, h)));
+				result = V::Select(V::Greater(x, V::Set(C::ExpMax)), V::Set(std::numeric_limits<T>::infinity()), result);
+				result = V::Select(V::Less(x, V::Set(C::ExpMin)), V::Set(0), result);
+				return V::Select(V::IsNaN(x), x, result);
+			}
+
+			template<typename T>
+			NN_TARGET_AVX2 typename Avx2Math<T>::Type LogFast(typename Avx2Math<T>::Type x)
+			{
+				typedef Avx2Math<T> V;
+				typedef Constants<T> C;
+				const typename V::Type zero = V::Set(0);
+				const typename V::Type one = V::Set(1);
+				const typename V::Type subnormal = V::Less(x, V::Set(C::MinNormal));
+				typename V::Type mantissa;
+				typename V::Type exponent = V::Exponent(V::Select(subnormal, V::Multiply(x, V::Set(C::SubnormalScale)), x), mantissa);
+				exponent = V::Subtract(exponent, V::Select(subnormal, V::Set(C::SubnormalExponent), zero));
+				const typename V::Type large = V::Greater(mantissa, V::Set(C::Sqrt2));
+				mantissa = V::Select(large, V::Multiply(mantissa, V::Set(static_cast<T>(0.5))), mantissa);
+				exponent = V::Select(large, V::Add(exponent, one), exponent);
+				const typename V::Type s = V::Divide(V::Subtract(mantissa, one), V::Add(mantissa, one));
+				const typename V::Type z = V::Multiply(s, s);
+				const typename V::Type logMantissa = V::MultiplyAdd(V::Multiply(s, z), Polynomial<T>(z, C::LogPolynomial), V::Add(s, s));
+				typename V::Type result = V::MultiplyAdd(exponent, V::Set(C::Ln2High), V::MultiplyAdd(exponent, V::Set(C::Ln2Low), logMantissa));
+				result = V::Select(V::Equal(x, V::Set(std::numeric_limits<T>::infinity())), x, result);
+				result = V::Select(V::Equal(x, zero), V::Set(-std::numeric_limits<T>::infinity()), result);
+				result = V::Select(V::Less(x, zero), V::Set(std::numeric_limits<T>::quiet_NaN()), result);
+				return V::Select(V::IsNaN(x), x, result);
+			}
+
+			// tanh(|x|) = (exp(2|x|) - 1) / (exp(2|x|) + 1), with exp - 1 kept exact for small x
+			template<typename T>
+			NN_TARGET_AVX2 typename Avx2Math<T>::Type TanhFast(typename Avx2Math<T>::Type x)
+			{
+				typedef Avx2Math<T> V;
+				typedef Constants<T> C;
+				const typename V::Type a = V::Min(V::Abs(x), V::Set(C::TanhMax));
+				typename V::Type k;
+				const typename V::Type expM1 = ReducedExpM1<T>(V::Add(a, a), k);
+				const typename V::Type scale = V::Pow2(k);
+				const typename V::Type e = V::MultiplyAdd(scale, expM1, V::Subtract(scale, V::Set(1)));
+				const typename V::Type result = V::CopySign(V::Divide(e, V::Add(e, V::Set(2))), x);
+				return V::Select(V::IsNaN(x), x, result);
+			}
+
+			// 1 / (1 + exp(-x)) for positive x and exp(x) / (1 + exp(x)) for negative x, so exp never overflows
+			// and the result keeps its precision down to the subnormal range
+			template<typename T>
+			NN_TARGET_AVX2 typename Avx2Math<T>::Type SigmoidFast(typename Avx2Math<T>::Type x)
+			{
+				typedef Avx2Math<T> V;
+				const typename V::Type one = V::Set(1);
+				const typename V::Type e = ExpFast<T>(V::Subtract(V::Set(0), V::Abs(x)));
+				const typename V::Type result = V::Divide(V::Select(V::Less(x, V::Set(0)), e, one), V::Add(one, e));
+				return V::Select(V::IsNaN(x), x, result);
+			}
+
+			struct ExpOp
+			{
+				template<typename T> NN_TARGET_AVX2 static typename Avx2Math<T>::Type Apply(typename Avx2Math<T>::Type x) { return ExpFast<T>(x); }
+			};
+
+			struct LogOp
+			{
+				template<typename T> NN_TARGET_AVX2 static typename Avx2Math<T>::Type Apply(typename Avx2Math<T>::Type x) { return LogFast<T>(x); }
+			};
+
+			struct TanhOp
+			{
+				template<typename T> NN_TARGET_AVX2 static typename Avx2Math<T>::Type Apply(typename Avx2Math<T>::Type x) { return TanhFast<T>(x); }
+			};
+
+			struct SigmoidOp
+			{
+				template<typename T> NN_TARGET_AVX2 static typename Avx2Math<T>::Type Apply(typename Avx2Math<T>::Type x) { return SigmoidFast<T>(x); }
+			};
+
+			// The tail shorter than a vector goes through a padded copy so every element gets the same approximation
+			template<typename Op, typename T>
+			NN_TARGET_AVX2 void MapAvx2(size_t n, const T* a, T* out)
+			{
+				typedef Avx2Math<T> V;
+				size_t i = 0;
+				for (; i + V::Width <= n; i += V::Width)
+					V::Store(out + i, Op::template Apply<T>(V::Load(a + i)));
+				if (i < n)
+				{
+					T tail[V::Width] = {};
+					for (size_t j = i; j < n; ++j)
+						tail[j - i] = a[j];
+					V::Store(tail, Op::template Apply<T>(V::Load(tail)));
+					for (size_t j = i; j < n; ++j)
+						out[j] = tail[j - i];
+				}
+			}
+#endif // NN_X86
+
+			template<typename T>
+			struct TranscendentalTable
+			{
+				typedef void(*Kernel)(size_t, const T*, T*);
+				Kernel Exp, Log, Tanh, Sigmoid;
+			};
+
+			template<typename T>
+			TranscendentalTable<T> SelectFastKernels()
+			{
+#ifdef NN_X86
+				const cpu::Features& features = cpu::GetFeatures();
+				if (features.AVX2 && features.FMA)
+					return TranscendentalTable<T>{ MapAvx2<ExpOp, T>, MapAvx2<LogOp, T>, MapAvx2<TanhOp, T>, MapAvx2<SigmoidOp, T> };
+#endif // NN_X86
+				return TranscendentalTable<T>{ ExpExact<T>, LogExact<T>, TanhExact<T>, SigmoidExact<T> };
+			}
+
+			template<typename T>
+			const TranscendentalTable<T>& Kernels()
+			{
+				static const TranscendentalTable<T> exact{ ExpExact<T>, LogExact<T>, TanhExact<T>, SigmoidExact<T> };
+				static const TranscendentalTable<T> fast = SelectFastKernels<T>();
+				return GetAccuracy() == FAST ? fast : exact;
+			}
+		}
+
+		void Exp(size_t n, const double* a, double* out) { Kernels<double>().Exp(n, a, out); }
+		void Exp(size_t n, const float* a, float* out) { Kernels<float>().Exp(n, a, out); }
+		void Log(size_t n, const double* a, double* out) { Kernels<double>().Log(n, a, out); }
+		void Log(size_t n, const float* a, float* out) { Kernels<float>().Log(n, a, out); }
+		void Tanh(size_t n, const double* a, double* out) { Kernels<double>().Tanh(n, a, out); }
+		void Tanh(size_t n, const float* a, float* out) { Kernels<float>().Tanh(n, a, out); }
+		void Sigmoid(size_t n, const double* a, double* out) { Kernels<double>().Sigmoid(n, a, out); }
+		void Sigmoid(size_t n, const float* a, float* out) { Kernels<float>().Sigmoid(n, a, out); }
+	}
+}
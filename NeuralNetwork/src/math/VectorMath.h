@@ -0,0 +1,57 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+#include <cstddef>
+
+namespace math
+{
+	// Accuracy of the transcendental kernels below, shared by the whole process
+	enum Accuracy
+	{
+		// The C runtime's exp/log/tanh, one element at a time
+		EXACT,
+		// Polynomial approximations evaluated with AVX2, CPUs without AVX2 and FMA fall back to EXACT
+		// Measured against long double, exp stays within 1.1 ulp of the exact result and log within 2 ulp for float and double;
+		// tanh and sigmoid divide two rounded results and stay within 4 ulp. Subnormal results are kept, not flushed to zero
+		FAST
+	};
+
+	// FAST is the default
+	void SetAccuracy(Accuracy accuracy);
+	Accuracy GetAccuracy();
+
+	// Transcendental kernels over contiguous float/double arrays, out may alias a
+	namespace kernel
+	{
+		// out[i] = exp(a[i])
+		void Exp(size_t n, const double* a, double* out);
+		void Exp(size_t n, const float* a, float* out);
+		// out[i] = log(a[i])
+		void Log(size_t n, const double* a, double* out);
+		void Log(size_t n, const float* a, float* out);
+		// out[i] = tanh(a[i])
+		void Tanh(size_t n, const double* a, double* out);
+		void Tanh(size_t n, const float* a, float* out);
+		// out[i] = 1 / (1 + exp(-a[i]))
+		void Sigmoid(size_t n, const double* a, double* out);
+		void Sigmoid(size_t n, const float* a, float* out);
+	}
+}
@@ -0,0 +1,158 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "Workspace.h"
+#include <vector>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif // _MSC_VER
+
+namespace math
+{
+	namespace
+	{
+		// Sizes are rounded up to one of four steps per power of two, wasting at most a fifth of a block
+		const size_t MIN_BLOCK = 64;
+		// Every block starts on a cache line, which is also the widest vector register
+		const size_t ALIGNMENT = 64;
+		const unsigned int CLASS_COUNT = 1 + 4 * 40;
+
+		std::atomic<unsigned long long> heapAllocations(0);
+
+		unsigned int SizeClass(size_t bytes, size_t& blockSize)
+		{
+			if (bytes <= MIN_BLOCK)
+			{
+				blockSize = MIN_BLOCK;
+				return 0;
+			}
+			size_t n = bytes - 1;
+			unsigned int exponent = 0;
+			while ((n >> exponent) > 1)
+				exponent++;
+			unsigned int shift = exponent - 2;
+			size_t steps = n >> shift;
+			blockSize = (steps + 1) << shift;
+			return 1 + (exponent - 6) * 4 + (unsigned int)(steps - 4);
+		}
+
+		void* AlignedAllocate(size_t bytes)
+		{
+#ifdef _MSC_VER
+			void* block = _aligned_malloc(bytes, ALIGNMENT);
+#else
+			void* block = nullptr;
+			if (posix_memalign(&block, ALIGNMENT, bytes) != 0)
+				block = nullptr;
+#endif // _MSC_VER
+			if (block == nullptr)
+				throw std::bad_alloc();
+			return block;
+		}
+
+		void AlignedFree(void* block)
+		{
+#ifdef _MSC_VER
+			_aligned_free(block);
+#else
+			free(block);
+#endif // _MSC_VER
+		}
+
+		// Set when the calling thread's free lists are destroyed at thread or process exit
+		// Buffers of matrices that outlive them, static ones or those of other thread_local objects, then bypass the lists
+		thread_local bool freeListsDestroyed = false;
+
+		struct FreeLists
+		{
+			std::vector<void*> Blocks[CLASS_COUNT];
+
+			void Release()
+			{
+				for (std::vector<void*>& blocks : Blocks)
+				{
+					for (void* block : blocks)
+						AlignedFree(block);
+					blocks.clear();
+				}
+			}
+
+			~FreeLists()
+			{
+				Release();
+				freeListsDestroyed = true;
+			}
+		};
+
+		// nullptr once the lists of the calling thread are gone
+		FreeLists* GetFreeLists()
+		{
+			if (freeListsDestroyed)
+				return nullptr;
+			thread_local FreeLists freeLists;
+			return &freeLists;
+		}
+	}
+
+	void* Workspace::Allocate(size_t bytes)
+	{
+		size_t blockSize;
+		unsigned int sizeClass = SizeClass(bytes, blockSize);
+		FreeLists* freeLists = GetFreeLists();
+		if (sizeClass < CLASS_COUNT && freeLists != nullptr)
+		{
+			std::vector<void*>& blocks = freeLists->Blocks[sizeClass];
+			if (!blocks.empty())
+			{
+				void* block = blocks.back();
+				blocks.pop_back();
+				return block;
+			}
+		}
+		heapAllocations++;
+		return AlignedAllocate(blockSize);
+	}
+
+	void Workspace::Deallocate(void* block, size_t bytes)
+	{
+		size_t blockSize;
+		unsigned int sizeClass = SizeClass(bytes, blockSize);
+		FreeLists* freeLists = GetFreeLists();
+		if (sizeClass < CLASS_COUNT && freeLists != nullptr)
+			freeLists->Blocks[sizeClass].push_back(block);
+		else
+			AlignedFree(block);
+	}
+
+	void Workspace::ReleaseMemory()
+	{
+		FreeLists* freeLists = GetFreeLists();
+		if (freeLists != nullptr)
+			freeLists->Release();
+	}
+
+	unsigned long long Workspace::GetHeapAllocationCount()
+	{
+		return heapAllocations;
+	}
+}
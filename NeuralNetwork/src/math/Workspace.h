@@ -0,0 +1,61 @@
+﻿/*
+Statically-linked deep learning library
+Copyright (C) 2020 Dušan Erdeljan, Nedeljko Vignjević
+
+This file is part of neural-network
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace math
+{
+	// Recycling allocator behind Matrix storage, every buffer is 64-byte aligned
+	// Freed buffers are kept on per-thread free lists bucketed by size and handed out again,
+	// so once a training step has run its shapes are cached and the matrices of later steps are taken from the lists
+	class Workspace
+	{
+	public:
+		static void* Allocate(size_t bytes);
+		static void Deallocate(void* block, size_t bytes);
+		// Returns the buffers cached by the calling thread to the heap
+		static void ReleaseMemory();
+		// Number of buffers the workspace had to take from the heap, allocations that do not go through it are not counted
+		static unsigned long long GetHeapAllocationCount();
+	};
+
+	// Elements constructed without a value are left uninitialised, containers that need zeros have to pass them
+	template<typename T>
+	class WorkspaceAllocator
+	{
+	public:
+		typedef T value_type;
+
+		WorkspaceAllocator() {}
+		template<typename U> WorkspaceAllocator(const WorkspaceAllocator<U>&) {}
+
+		T* allocate(size_t count) { return static_cast<T*>(Workspace::Allocate(count * sizeof(T))); }
+		void deallocate(T* block, size_t count) { Workspace::Deallocate(block, count * sizeof(T)); }
+
+		template<typename U> void construct(U* element) { ::new((void*)element) U; }
+		template<typename U, typename... Args> void construct(U* element, Args&&... args) { ::new((void*)element) U(std::forward<Args>(args)...); }
+
+		template<typename U> bool operator==(const WorkspaceAllocator<U>&) const { return true; }
+		template<typename U> bool operator!=(const WorkspaceAllocator<U>&) const { return false; }
+	};
+}
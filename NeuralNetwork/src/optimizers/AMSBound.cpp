@@ -24,7 +24,7 @@ namespace nn
 {
 	namespace optimizer
 	{
-		AMSBound::AMSBound(double lr, double beta1, double beta2, double final_lr, double gamma)
+		AMSBound::AMSBound(Scalar lr, Scalar beta1, Scalar beta2, Scalar final_lr, Scalar gamma)
 			: Optimizer(lr), m_Beta1(beta1), m_Beta2(beta2), m_FinalLearningRate(final_lr), m_Gamma(gamma)
 		{
 
@@ -32,39 +32,39 @@ namespace nn
 
 		void AMSBound::UpdateLayer(Layer & layer, Matrix & deltaWeight, Matrix & deltaBias, int layerIndex, unsigned int epoch)
 		{
-			double stepSize = m_LearningRate * (sqrt(1.0 - pow(m_Beta2, epoch)) / (1.0 - pow(m_Beta1, epoch)));
-			double lowerBound = m_FinalLearningRate * (1.0 - 1.0 / (m_Gamma*epoch + 1.0));
-			double upperBound = m_FinalLearningRate * (1.0 + 1.0 / (m_Gamma*epoch));
+			Scalar stepSize = m_LearningRate * (sqrt(1.0 - pow(m_Beta2, epoch)) / (1.0 - pow(m_Beta1, epoch)));
+			Scalar lowerBound = m_FinalLearningRate * (1.0 - 1.0 / (m_Gamma*epoch + 1.0));
+			Scalar upperBound = m_FinalLearningRate * (1.0 + 1.0 / (m_Gamma*epoch));
 			if (msWeight.find(layerIndex) == msWeight.end())
 			{
 				msWeight[layerIndex] = (1.0 - m_Beta1)*deltaWeight;
-				vsWeight[layerIndex] = (1.0 - m_Beta2)*Matrix::Map(deltaWeight, [](double x) { return x*x; });
+				vsWeight[layerIndex] = (1.0 - m_Beta2)*Matrix::Map(deltaWeight, [](Scalar x) { return x*x; });
 				vhatsWeight[layerIndex] = vsWeight[layerIndex];
 				msBias[layerIndex] = (1.0 - m_Beta1)*deltaBias;
-				vsBias[layerIndex] = (1.0 - m_Beta2)*Matrix::Map(deltaBias, [](double x) { return x*x; });
+				vsBias[layerIndex] = (1.0 - m_Beta2)*Matrix::Map(deltaBias, [](Scalar x) { return x*x; });
 				vhatsBias[layerIndex] = vsBias[layerIndex];
 			}
 			else
 			{
 				msWeight[layerIndex] = m_Beta1*msWeight[layerIndex] + (1.0 - m_Beta1)*deltaWeight;
-				vsWeight[layerIndex] = m_Beta2*vsWeight[layerIndex] + (1.0 - m_Beta2)*Matrix::Map(deltaWeight, [](double x) { return x*x; });
+				vsWeight[layerIndex] = m_Beta2*vsWeight[layerIndex] + (1.0 - m_Beta2)*Matrix::Map(deltaWeight, [](Scalar x) { return x*x; });
 				vhatsWeight[layerIndex] = Matrix::Max(vhatsWeight[layerIndex], vsWeight[layerIndex]);
 				msBias[layerIndex] = m_Beta1*msBias[layerIndex] + (1.0 - m_Beta1)*deltaBias;
-				vsBias[layerIndex] = m_Beta2*vsBias[layerIndex] + (1.0 - m_Beta2)*Matrix::Map(deltaBias, [](double x) { return x*x; });
+				vsBias[layerIndex] = m_Beta2*vsBias[layerIndex] + (1.0 - m_Beta2)*Matrix::Map(deltaBias, [](Scalar x) { return x*x; });
 				vhatsBias[layerIndex] = Matrix::Max(vhatsBias[layerIndex], vsBias[layerIndex]);
 			}
-			Matrix boundedWeight = Matrix::Map(vhatsWeight[layerIndex], [stepSize, lowerBound, upperBound](double x)
+			Matrix boundedWeight = Matrix::Map(vhatsWeight[layerIndex], [stepSize, lowerBound, upperBound](Scalar x)
 			{
-				double val = stepSize / (sqrt(x) + 1e-7);
+				Scalar val = stepSize / (sqrt(x) + 1e-7);
 				return std::min(std::max(val, lowerBound), upperBound);
 			});
-			Matrix boundedBias = Matrix::Map(vhatsBias[layerIndex], [stepSize, lowerBound, upperBound](double x)
+			Matrix boundedBias = Matrix::Map(vhatsBias[layerIndex], [stepSize, lowerBound, upperBound](Scalar x)
 			{
-				double val = stepSize / (sqrt(x) + 1e-7);
+				Scalar val = stepSize / (sqrt(x) + 1e-7);
 				return std::min(std::max(val, lowerBound), upperBound);
 			});
-			layer.WeightMatrix -= msWeight[layerIndex].DotProduct(boundedWeight);
-			layer.BiasMatrix -= msBias[layerIndex].DotProduct(boundedBias);
+			layer.WeightMatrix -= Matrix::DotProduct(msWeight[layerIndex], boundedWeight);
+			layer.BiasMatrix -= Matrix::DotProduct(msBias[layerIndex], boundedBias);
 		}
 
 		void AMSBound::Reset()
@@ -24,7 +24,7 @@ namespace nn
 {
 	namespace optimizer
 	{
-		Adagrad::Adagrad(double lr) : Optimizer(lr)
+		Adagrad::Adagrad(Scalar lr) : Optimizer(lr)
 		{
 
 		}
@@ -33,16 +33,16 @@ namespace nn
 		{
 			if (gradSquaredW.find(layerIndex) == gradSquaredW.end())
 			{
-				gradSquaredW[layerIndex] = Matrix::Map(deltaWeight, [](double x) { return x*x; });
-				gradSquaredB[layerIndex] = Matrix::Map(deltaBias, [](double x) { return x*x; });
+				gradSquaredW[layerIndex] = Matrix::Map(deltaWeight, [](Scalar x) { return x*x; });
+				gradSquaredB[layerIndex] = Matrix::Map(deltaBias, [](Scalar x) { return x*x; });
 			}
 			else
 			{
-				gradSquaredW[layerIndex] += Matrix::Map(deltaWeight, [](double x) { return x*x; });
-				gradSquaredB[layerIndex] += Matrix::Map(deltaBias, [](double x) { return x*x; });
+				gradSquaredW[layerIndex] += Matrix::Map(deltaWeight, [](Scalar x) { return x*x; });
+				gradSquaredB[layerIndex] += Matrix::Map(deltaBias, [](Scalar x) { return x*x; });
 			}
-			layer.WeightMatrix -= (m_LearningRate * deltaWeight) / Matrix::Map(gradSquaredW[layerIndex], [](double x) { return sqrt(x) + 1e-7; });
-			layer.BiasMatrix -= (m_LearningRate * deltaBias) / Matrix::Map(gradSquaredB[layerIndex], [](double x) { return sqrt(x) + 1e-7; });
+			layer.WeightMatrix -= (m_LearningRate * deltaWeight) / Matrix::Map(gradSquaredW[layerIndex], [](Scalar x) { return sqrt(x) + 1e-7; });
+			layer.BiasMatrix -= (m_LearningRate * deltaBias) / Matrix::Map(gradSquaredB[layerIndex], [](Scalar x) { return sqrt(x) + 1e-7; });
 		}
 
 		void Adagrad::Reset()
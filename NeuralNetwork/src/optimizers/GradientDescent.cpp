@@ -24,15 +24,20 @@ namespace nn
 {
 	namespace optimizer
 	{
-		GradientDescent::GradientDescent(double lr) : Optimizer(lr)
+		GradientDescent::GradientDescent(Scalar lr) : Optimizer(lr)
 		{
 
 		}
 
 		void GradientDescent::UpdateLayer(Layer& layer, Matrix& deltaWeight, Matrix& deltaBias, int layerIndex, unsigned int epoch)
 		{
-			layer.WeightMatrix -= m_LearningRate * deltaWeight;
-			layer.BiasMatrix -= m_LearningRate * deltaBias;
+			layer.WeightMatrix.AddScaled(deltaWeight, -m_LearningRate);
+			layer.BiasMatrix.AddScaled(deltaBias, -m_LearningRate);
+		}
+
+		std::shared_ptr<Optimizer> GradientDescent::Clone() const
+		{
+			return std::make_shared<GradientDescent>(m_LearningRate);
 		}
 	}
 }
\ No newline at end of file
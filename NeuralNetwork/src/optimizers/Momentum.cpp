@@ -24,7 +24,7 @@ namespace nn
 {
 	namespace optimizer
 	{
-		Momentum::Momentum(double lr, double momentum) : Optimizer(lr), m_Momentum(momentum)
+		Momentum::Momentum(Scalar lr, Scalar momentum) : Optimizer(lr), m_Momentum(momentum)
 		{
 
 		}
@@ -50,5 +50,10 @@ namespace nn
 			lastDeltaWeight.clear();
 			lastDeltaBias.clear();
 		}
+
+		std::shared_ptr<Optimizer> Momentum::Clone() const
+		{
+			return std::make_shared<Momentum>(m_LearningRate, m_Momentum);
+		}
 	}
 }
\ No newline at end of file
@@ -24,7 +24,7 @@ namespace nn
 {
 	namespace optimizer
 	{
-		Nadam::Nadam(double lr, double beta1, double beta2) : Optimizer(lr), m_Beta1(beta1), m_Beta2(beta2)
+		Nadam::Nadam(Scalar lr, Scalar beta1, Scalar beta2) : Optimizer(lr), m_Beta1(beta1), m_Beta2(beta2)
 		{
 
 		}
@@ -35,19 +35,19 @@ namespace nn
 			{
 				// Weights
 				firstMomentW[layerIndex] = (1 - m_Beta1) * deltaWeight;
-				secondMomentW[layerIndex] = (1 - m_Beta2) * Matrix::Map(deltaWeight, [](double x) { return x*x; });
+				secondMomentW[layerIndex] = (1 - m_Beta2) * Matrix::Map(deltaWeight, [](Scalar x) { return x*x; });
 				// Biases
 				firstMomentB[layerIndex] = (1 - m_Beta1) * deltaBias;
-				secondMomentB[layerIndex] = Matrix::Map(deltaBias, [](double x) { return abs(x); });
+				secondMomentB[layerIndex] = Matrix::Map(deltaBias, [](Scalar x) { return abs(x); });
 			}
 			else
 			{
 				// Weights
 				firstMomentW[layerIndex] = firstMomentW[layerIndex] * m_Beta1 + (1 - m_Beta1) * deltaWeight;
-				secondMomentW[layerIndex] = secondMomentW[layerIndex] * m_Beta2 + (1 - m_Beta2) * Matrix::Map(deltaWeight, [](double x) { return x*x; });
+				secondMomentW[layerIndex] = secondMomentW[layerIndex] * m_Beta2 + (1 - m_Beta2) * Matrix::Map(deltaWeight, [](Scalar x) { return x*x; });
 				// Biases
 				firstMomentB[layerIndex] = firstMomentB[layerIndex] * m_Beta1 + (1 - m_Beta1) * deltaBias;
-				secondMomentB[layerIndex] = secondMomentB[layerIndex] * m_Beta2 + (1 - m_Beta2) * Matrix::Map(deltaBias, [](double x) { return x*x; });
+				secondMomentB[layerIndex] = secondMomentB[layerIndex] * m_Beta2 + (1 - m_Beta2) * Matrix::Map(deltaBias, [](Scalar x) { return x*x; });
 			}
 
 			Matrix firstUnbiasW = firstMomentW[layerIndex] / (1 - pow(m_Beta1, epoch));
@@ -55,8 +55,8 @@ namespace nn
 			Matrix firstUnbiasB = firstMomentB[layerIndex] / (1 - pow(m_Beta1, epoch));
 			Matrix secondUnbiasB = secondMomentB[layerIndex] / (1 - pow(m_Beta2, epoch));
 
-			layer.WeightMatrix -= (m_LearningRate * (firstUnbiasW * m_Beta1 + (1 - m_Beta1) / (1 - pow(m_Beta1, epoch)) * deltaWeight)) / Matrix::Map(secondUnbiasW, [](double x) { return sqrt(x) + 1e-7; });
-			layer.BiasMatrix -= (m_LearningRate * (firstUnbiasB * m_Beta1 + (1 - m_Beta1) / (1 - pow(m_Beta1, epoch)) * deltaBias)) / Matrix::Map(secondUnbiasB, [](double x) { return sqrt(x) + 1e-7; });
+			layer.WeightMatrix -= (m_LearningRate * (firstUnbiasW * m_Beta1 + (1 - m_Beta1) / (1 - pow(m_Beta1, epoch)) * deltaWeight)) / Matrix::Map(secondUnbiasW, [](Scalar x) { return sqrt(x) + 1e-7; });
+			layer.BiasMatrix -= (m_LearningRate * (firstUnbiasB * m_Beta1 + (1 - m_Beta1) / (1 - pow(m_Beta1, epoch)) * deltaBias)) / Matrix::Map(secondUnbiasB, [](Scalar x) { return sqrt(x) + 1e-7; });
 		}
 
 		void Nadam::Reset()
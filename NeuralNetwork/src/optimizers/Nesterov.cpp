@@ -24,7 +24,7 @@ namespace nn
 {
 	namespace optimizer
 	{
-		Nesterov::Nesterov(double lr, double momentum) : Optimizer(lr), m_Momentum(momentum)
+		Nesterov::Nesterov(Scalar lr, Scalar momentum) : Optimizer(lr), m_Momentum(momentum)
 		{
 
 		}
@@ -35,8 +35,8 @@ namespace nn
 			Matrix previousBias;
 			if (lastMomentWeight.find(layerIndex) == lastMomentWeight.end())
 			{
-				previousWeight = Matrix::Map(deltaWeight, [](double x) { return 0; });
-				previousBias = Matrix::Map(deltaBias, [](double x) { return 0; });
+				previousWeight = Matrix::Map(deltaWeight, [](Scalar x) { return 0; });
+				previousBias = Matrix::Map(deltaBias, [](Scalar x) { return 0; });
 				lastMomentWeight[layerIndex] = -m_LearningRate*deltaWeight;
 				lastMomentBias[layerIndex] = -m_LearningRate*deltaBias;
 			}
@@ -34,40 +34,45 @@ namespace nn
 		class Optimizer
 		{
 		protected:
-			double m_LearningRate;
-			Optimizer(double lr) : m_LearningRate(lr) {}
+			Scalar m_LearningRate;
+			Optimizer(Scalar lr) : m_LearningRate(lr) {}
 		public:
 			virtual void UpdateLayer(Layer& layer, Matrix& deltaWeight, Matrix& deltaBias, int layerIndex = 0, unsigned int epoch = 0) = 0;
 			virtual void Reset() {}
+			// New optimizer with its own empty state for one Hogwild training thread
+			// nullptr for optimizers whose update can not be applied to shared weights without locks
+			virtual std::shared_ptr<Optimizer> Clone() const { return nullptr; }
 		};
 
 		class GradientDescent : public Optimizer
 		{
 		public:
-			GradientDescent(double lr);
+			GradientDescent(Scalar lr);
 			void UpdateLayer(Layer& layer, Matrix& deltaWeight, Matrix& deltaBias, int layerIndex = 0, unsigned int epoch = 0) override;
+			std::shared_ptr<Optimizer> Clone() const override;
 		};
 
 		class Momentum : public Optimizer
 		{
 		private:
-			double m_Momentum;
+			Scalar m_Momentum;
 			std::unordered_map<unsigned int, Matrix> lastDeltaWeight;
 			std::unordered_map<unsigned int, Matrix> lastDeltaBias;
 		public:
-			Momentum(double lr, double momentum = 0.9);
+			Momentum(Scalar lr, Scalar momentum = 0.9);
 			void UpdateLayer(Layer& layer, Matrix& deltaWeight, Matrix& deltaBias, int layerIndex = 0, unsigned int epoch = 0) override;
 			void Reset() override;
+			std::shared_ptr<Optimizer> Clone() const override;
 		};
 
 		class Nesterov : public Optimizer
 		{
 		private:
-			double m_Momentum;
+			Scalar m_Momentum;
 			std::unordered_map<unsigned int, Matrix> lastMomentWeight;
 			std::unordered_map<unsigned int, Matrix> lastMomentBias;
 		public:
-			Nesterov(double lr, double momentum = 0.9);
+			Nesterov(Scalar lr, Scalar momentum = 0.9);
 			void UpdateLayer(Layer& layer, Matrix& deltaWeight, Matrix& deltaBias, int layerIndex = 0, unsigned int epoch = 0) override;
 			void Reset() override;
 		};
@@ -78,7 +83,7 @@ namespace nn
 			std::unordered_map<unsigned int, Matrix> gradSquaredW;
 			std::unordered_map<unsigned int, Matrix> gradSquaredB;
 		public:
-			Adagrad(double lr);
+			Adagrad(Scalar lr);
 			void UpdateLayer(Layer& layer, Matrix& deltaWeight, Matrix& deltaBias, int layerIndex = 0, unsigned int epoch = 0) override;
 			void Reset() override;
 		};
@@ -86,11 +91,11 @@ namespace nn
 		class RMSProp : public Optimizer
 		{
 		private:
-			double m_Beta;
+			Scalar m_Beta;
 			std::unordered_map<unsigned int, Matrix> gradSquaredW;
 			std::unordered_map<unsigned int, Matrix> gradSquaredB;
 		public:
-			RMSProp(double lr, double beta = 0.99);
+			RMSProp(Scalar lr, Scalar beta = 0.99);
 			void UpdateLayer(Layer& layer, Matrix& deltaWeight, Matrix& deltaBias, int layerIndex = 0, unsigned int epoch = 0) override;
 			void Reset() override;
 		};
@@ -98,11 +103,11 @@ namespace nn
 		class Adadelta : public Optimizer
 		{
 		private:
-			double m_Beta;
+			Scalar m_Beta;
 			std::unordered_map<unsigned int, Matrix> gradSquaredW;
 			std::unordered_map<unsigned int, Matrix> gradSquaredB;
 		public:
-			Adadelta(double lr, double beta = 0.99);
+			Adadelta(Scalar lr, Scalar beta = 0.99);
 			void UpdateLayer(Layer& layer, Matrix& deltaWeight, Matrix& deltaBias, int layerIndex = 0, unsigned int epoch = 0) override;
 			void Reset() override;
 		};
@@ -110,8 +115,8 @@ namespace nn
 		class Adam : public Optimizer
 		{
 		private:
-			double m_Beta1;
-			double m_Beta2;
+			Scalar m_Beta1;
+			Scalar m_Beta2;
 			// Weights
 			std::unordered_map<unsigned int, Matrix> firstMomentW;
 			std::unordered_map<unsigned int, Matrix> secondMomentW;
@@ -119,7 +124,7 @@ namespace nn
 			std::unordered_map<unsigned int, Matrix> firstMomentB;
 			std::unordered_map<unsigned int, Matrix> secondMomentB;
 		public:
-			Adam(double lr, double beta1 = 0.9, double beta2 = 0.999);
+			Adam(Scalar lr, Scalar beta1 = 0.9, Scalar beta2 = 0.999);
 			void UpdateLayer(Layer& layer, Matrix& deltaWeight, Matrix& deltaBias, int layerIndex = 0, unsigned int epoch = 0) override;
 			void Reset() override;
 		};
@@ -127,8 +132,8 @@ namespace nn
 		class Nadam : public Optimizer
 		{
 		private:
-			double m_Beta1;
-			double m_Beta2;
+			Scalar m_Beta1;
+			Scalar m_Beta2;
 			// Weights
 			std::unordered_map<unsigned int, Matrix> firstMomentW;
 			std::unordered_map<unsigned int, Matrix> secondMomentW;
@@ -136,7 +141,7 @@ namespace nn
 			std::unordered_map<unsigned int, Matrix> firstMomentB;
 			std::unordered_map<unsigned int, Matrix> secondMomentB;
 		public:
-			Nadam(double lr, double beta1 = 0.9, double beta2 = 0.999);
+			Nadam(Scalar lr, Scalar beta1 = 0.9, Scalar beta2 = 0.999);
 			void UpdateLayer(Layer& layer, Matrix& deltaWeight, Matrix& deltaBias, int layerIndex = 0, unsigned int epoch = 0) override;
 			void Reset() override;
 		};
@@ -144,8 +149,8 @@ namespace nn
 		class Adamax : public Optimizer
 		{
 		private:
-			double m_Beta1;
-			double m_Beta2;
+			Scalar m_Beta1;
+			Scalar m_Beta2;
 			// Weights
 			std::unordered_map<unsigned int, Matrix> firstMomentW;
 			std::unordered_map<unsigned int, Matrix> infinityNormW;
@@ -153,7 +158,7 @@ namespace nn
 			std::unordered_map<unsigned int, Matrix> firstMomentB;
 			std::unordered_map<unsigned int, Matrix> infinityNormB;
 		public:
-			Adamax(double lr, double beta1 = 0.9, double beta2 = 0.999);
+			Adamax(Scalar lr, Scalar beta1 = 0.9, Scalar beta2 = 0.999);
 			void UpdateLayer(Layer& layer, Matrix& deltaWeight, Matrix& deltaBias, int layerIndex = 0, unsigned int epoch = 0) override;
 			void Reset() override;
 		};
@@ -161,8 +166,8 @@ namespace nn
 		class AMSGrad : public Optimizer
 		{
 		private:
-			double m_Beta1;
-			double m_Beta2;
+			Scalar m_Beta1;
+			Scalar m_Beta2;
 			// Weights
 			std::unordered_map<unsigned int, Matrix> firstMomentW;
 			std::unordered_map<unsigned int, Matrix> secondMomentW;
@@ -172,7 +177,7 @@ namespace nn
 			std::unordered_map<unsigned int, Matrix> secondMomentB;
 			std::unordered_map<unsigned int, Matrix> infinityNormB;
 		public:
-			AMSGrad(double lr, double beta1 = 0.9, double beta2 = 0.999);
+			AMSGrad(Scalar lr, Scalar beta1 = 0.9, Scalar beta2 = 0.999);
 			void UpdateLayer(Layer& layer, Matrix& deltaWeight, Matrix& deltaBias, int layerIndex = 0, unsigned int epoch = 0) override;
 			void Reset() override;
 		};
@@ -180,10 +185,10 @@ namespace nn
 		class Adabound : public Optimizer
 		{
 		private:
-			double m_Beta1;
-			double m_Beta2;
-			double m_FinalLearningRate;
-			double m_Gamma;
+			Scalar m_Beta1;
+			Scalar m_Beta2;
+			Scalar m_FinalLearningRate;
+			Scalar m_Gamma;
 			// Weights
 			std::unordered_map<unsigned int, Matrix> msWeight;
 			std::unordered_map<unsigned int, Matrix> vsWeight;
@@ -191,7 +196,7 @@ namespace nn
 			std::unordered_map<unsigned int, Matrix> msBias;
 			std::unordered_map<unsigned int, Matrix> vsBias;
 		public:
-			Adabound(double lr, double beta1 = 0.9, double beta2 = 0.999, double final_lr = 0.1, double gamma = 1e-3);
+			Adabound(Scalar lr, Scalar beta1 = 0.9, Scalar beta2 = 0.999, Scalar final_lr = 0.1, Scalar gamma = 1e-3);
 			void UpdateLayer(Layer& layer, Matrix& deltaWeight, Matrix& deltaBias, int layerIndex = 0, unsigned int epoch = 0) override;
 			void Reset() override;
 		};
@@ -199,10 +204,10 @@ namespace nn
 		class AMSBound : public Optimizer
 		{
 		private:
-			double m_Beta1;
-			double m_Beta2;
-			double m_FinalLearningRate;
-			double m_Gamma;
+			Scalar m_Beta1;
+			Scalar m_Beta2;
+			Scalar m_FinalLearningRate;
+			Scalar m_Gamma;
 			// Weights
 			std::unordered_map<unsigned int, Matrix> msWeight;
 			std::unordered_map<unsigned int, Matrix> vsWeight;
@@ -212,7 +217,7 @@ namespace nn
 			std::unordered_map<unsigned int, Matrix> vsBias;
 			std::unordered_map<unsigned int, Matrix> vhatsBias;
 		public:
-			AMSBound(double lr, double beta1 = 0.9, double beta2 = 0.999, double final_lr = 0.1, double gamma = 1e-3);
+			AMSBound(Scalar lr, Scalar beta1 = 0.9, Scalar beta2 = 0.999, Scalar final_lr = 0.1, Scalar gamma = 1e-3);
 			void UpdateLayer(Layer& layer, Matrix& deltaWeight, Matrix& deltaBias, int layerIndex = 0, unsigned int epoch = 0) override;
 			void Reset() override;
 		};
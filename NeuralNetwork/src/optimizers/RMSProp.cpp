@@ -24,7 +24,7 @@ namespace nn
 {
 	namespace optimizer
 	{
-		RMSProp::RMSProp(double lr, double beta) : Optimizer(lr), m_Beta(beta)
+		RMSProp::RMSProp(Scalar lr, Scalar beta) : Optimizer(lr), m_Beta(beta)
 		{
 
 		}
@@ -33,16 +33,16 @@ namespace nn
 		{
 			if (gradSquaredW.find(layerIndex) == gradSquaredW.end())
 			{
-				gradSquaredW[layerIndex] = (1 - m_Beta) * Matrix::Map(deltaWeight, [](double x) { return x*x; });
-				gradSquaredB[layerIndex] = (1 - m_Beta) * Matrix::Map(deltaBias, [](double x) { return x*x; });
+				gradSquaredW[layerIndex] = (1 - m_Beta) * Matrix::Map(deltaWeight, [](Scalar x) { return x*x; });
+				gradSquaredB[layerIndex] = (1 - m_Beta) * Matrix::Map(deltaBias, [](Scalar x) { return x*x; });
 			}
 			else
 			{
-				gradSquaredW[layerIndex] = m_Beta * gradSquaredW[layerIndex] + (1 - m_Beta) * Matrix::Map(deltaWeight, [](double x) { return x*x; });
-				gradSquaredB[layerIndex] = m_Beta * gradSquaredB[layerIndex] + (1 - m_Beta) * Matrix::Map(deltaBias, [](double x) { return x*x; });
+				gradSquaredW[layerIndex] = m_Beta * gradSquaredW[layerIndex] + (1 - m_Beta) * Matrix::Map(deltaWeight, [](Scalar x) { return x*x; });
+				gradSquaredB[layerIndex] = m_Beta * gradSquaredB[layerIndex] + (1 - m_Beta) * Matrix::Map(deltaBias, [](Scalar x) { return x*x; });
 			}
-			layer.WeightMatrix -= (m_LearningRate * deltaWeight) / Matrix::Map(gradSquaredW[layerIndex], [](double x) { return sqrt(x) + 1e-7; });
-			layer.BiasMatrix -= (m_LearningRate * deltaBias) / Matrix::Map(gradSquaredB[layerIndex], [](double x) { return sqrt(x) + 1e-7; });
+			layer.WeightMatrix -= (m_LearningRate * deltaWeight) / Matrix::Map(gradSquaredW[layerIndex], [](Scalar x) { return sqrt(x) + 1e-7; });
+			layer.BiasMatrix -= (m_LearningRate * deltaBias) / Matrix::Map(gradSquaredB[layerIndex], [](Scalar x) { return sqrt(x) + 1e-7; });
 		}
 
 		void RMSProp::Reset()
@@ -26,7 +26,7 @@ namespace nn
 	{
 		void L1Regularizer::Regularize(const Matrix& weights, Matrix& gradient) const
 		{
-			gradient += Matrix::Map(weights, [l1 = m_L1](double x) { return x >= 0 ? l1 : -l1; });
+			gradient += Matrix::Map(weights, [l1 = m_L1](Scalar x) { return x >= 0 ? l1 : -l1; });
 		}
 	}
 }
\ No newline at end of file
@@ -40,7 +40,7 @@ namespace nn
 		class L1Regularizer : public Regularizer
 		{
 		private:
-			double m_L1 = 0.01;
+			Scalar m_L1 = 0.01;
 		public:
 			void Regularize(const Matrix& weights, Matrix& gradient) const override;
 		};
@@ -48,7 +48,7 @@ namespace nn
 		class L2Regularizer : public Regularizer
 		{
 		private:
-			double m_L2 = 0.01;
+			Scalar m_L2 = 0.01;
 		public:
 			void Regularize(const Matrix& weights, Matrix& gradient) const override;
 		};
@@ -56,8 +56,8 @@ namespace nn
 		class L1L2Regularizer : public Regularizer
 		{
 		private:
-			double m_L1 = 0.01;
-			double m_L2 = 0.01;
+			Scalar m_L1 = 0.01;
+			Scalar m_L2 = 0.01;
 		public:
 			void Regularize(const Matrix& weights, Matrix& gradient) const override;
 		};
@@ -0,0 +1,60 @@
+#include <cstdio>
+#include "Test.h"
+#include "NeuralNetwork.h"
+
+TEST(DatasetRejectsMismatchedSamples)
+{
+	nn::Dataset dataset(3, 2);
+	dataset.AddSample({ 1, 2, 3 }, { 0, 1 });
+	CHECK_THROWS(dataset.AddSample({ 1, 2 }, { 0, 1 }));
+	CHECK_THROWS(dataset.AddSample({ 1, 2, 3 }, { 1 }));
+	CHECK_THROWS(dataset.AddSample({ 1, 2, 3 }, 1));
+	CHECK(dataset.GetSize() == 1);
+	const std::vector<Scalar> target = { 0, 1 };
+	CHECK_THROWS(nn::Dataset({ nn::TrainingData({ 1, 2 }, target), nn::TrainingData({ 1, 2, 3 }, target) }));
+	CHECK_THROWS(nn::Dataset({ nn::TrainingData({ 1, 2 }, target), nn::TrainingData({ 1, 2 }, { 0, 1, 0 }) }));
+	CHECK_THROWS(nn::Dataset({ nn::TrainingData(SparseMatrix::BuildRowVector(2, { 1 }, { 1 }), target),
+		nn::TrainingData(SparseMatrix::BuildRowVector(5, { 4 }, { 1 }), target) }));
+	CHECK(nn::Dataset({ nn::TrainingData({ 1, 2 }, target), nn::TrainingData(SparseMatrix::BuildRowVector(2, { 1 }, { 3 }), target) }).GetInputs(1)[1] == 3);
+}
+
+TEST(MappedDatasetRejectsLabelsAboveClassCount)
+{
+	const char* inputsFile = "DataTestsInputs.raw";
+	const char* labelsFile = "DataTestsLabels.raw";
+	const unsigned char inputs[] = { 0, 64, 128, 255, 32, 16 };
+	const unsigned char labels[] = { 1, 0, 3 };
+	std::ofstream(inputsFile, std::ios::binary).write((const char*)inputs, sizeof(inputs));
+	std::ofstream(labelsFile, std::ios::binary).write((const char*)labels, sizeof(labels));
+	nn::MappedDataset dataset = nn::MappedDataset::LoadRaw(inputsFile, 2, labelsFile, 4);
+	CHECK(dataset.GetSize() == 3 && dataset.GetLabel(2) == 3);
+	CHECK_THROWS(nn::MappedDataset::LoadRaw(inputsFile, 2, labelsFile, 3));
+	std::remove(inputsFile);
+	std::remove(labelsFile);
+}
+
+TEST(MappedDatasetRejectsBadIdxHeaders)
+{
+	const char* inputsFile = "DataTestsInputs.idx";
+	const char* labelsFile = "DataTestsLabels.idx";
+	const unsigned char labels[] = { 0, 0, 8, 1, 0, 0, 0, 2, 1, 0 };
+	std::ofstream(labelsFile, std::ios::binary).write((const char*)labels, sizeof(labels));
+	// 2 samples of 2 x 3 bytes
+	const unsigned char inputs[] = { 0, 0, 8, 3, 0, 0, 0, 2, 0, 0, 0, 2, 0, 0, 0, 3, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+	std::ofstream(inputsFile, std::ios::binary).write((const char*)inputs, sizeof(inputs));
+	{
+		// Unmapped before the file is rewritten
+		nn::MappedDataset dataset = nn::MappedDataset::LoadIdx(inputsFile, labelsFile, 2);
+		CHECK(dataset.GetSize() == 2 && dataset.GetInputSize() == 6 && dataset.GetInputs(1)[0] == 7);
+	}
+	// No dimensions at all
+	const unsigned char noDimensions[] = { 0, 0, 8, 0 };
+	std::ofstream(inputsFile, std::ios::binary).write((const char*)noDimensions, sizeof(noDimensions));
+	CHECK_THROWS(nn::MappedDataset::LoadIdx(inputsFile, labelsFile, 2));
+	// 2 samples of 65536 x 65536 bytes, the sample size does not fit in 32 bits
+	const unsigned char largeSamples[] = { 0, 0, 8, 3, 0, 0, 0, 2, 0, 1, 0, 0, 0, 1, 0, 0 };
+	std::ofstream(inputsFile, std::ios::binary).write((const char*)largeSamples, sizeof(largeSamples));
+	CHECK_THROWS(nn::MappedDataset::LoadIdx(inputsFile, labelsFile, 2));
+	std::remove(inputsFile);
+	std::remove(labelsFile);
+}
@@ -0,0 +1,151 @@
+#include <random>
+#include "Test.h"
+#include "src/math/Gemm.h"
+#include "src/math/Matrix.h"
+#include "src/math/QuantizedMatrix.h"
+
+namespace
+{
+	const double TOLERANCE = sizeof(Scalar) == sizeof(float) ? 1e-4 : 1e-12;
+
+	std::vector<Scalar> RandomBuffer(size_t size, std::mt19937& engine)
+	{
+		std::uniform_real_distribution<double> distribution(-1, 1);
+		std::vector<Scalar> buffer(size);
+		for (Scalar& x : buffer)
+			x = (Scalar)distribution(engine);
+		return buffer;
+	}
+
+	// Element (row, column) of op(A) for A stored row-major with row stride ld
+	Scalar Element(const std::vector<Scalar>& a, math::Operation trans, unsigned int ld, unsigned int row, unsigned int column)
+	{
+		return trans == math::TRANSPOSE ? a[(size_t)column*ld + row] : a[(size_t)row*ld + column];
+	}
+
+	void CheckGemm(math::Operation transA, math::Operation transB, unsigned int m, unsigned int n, unsigned int k, unsigned int padding)
+	{
+		std::mt19937 engine(m * 131 + n * 17 + k);
+		const unsigned int aRows = transA == math::TRANSPOSE ? k : m, aColumns = transA == math::TRANSPOSE ? m : k;
+		const unsigned int bRows = transB == math::TRANSPOSE ? n : k, bColumns = transB == math::TRANSPOSE ? k : n;
+		const unsigned int lda = aColumns + padding, ldb = bColumns + padding, ldc = n + padding;
+		std::vector<Scalar> a = RandomBuffer((size_t)aRows*lda, engine);
+		std::vector<Scalar> b = RandomBuffer((size_t)bRows*ldb, engine);
+		std::vector<Scalar> c = RandomBuffer((size_t)m*ldc, engine);
+		std::vector<Scalar> expected(c);
+		const Scalar alpha = (Scalar)0.75, beta = (Scalar)-0.5;
+		for (unsigned int i = 0; i < m; ++i)
+			for (unsigned int j = 0; j < n; ++j)
+			{
+				double sum = 0;
+				for (unsigned int p = 0; p < k; ++p)
+					sum += (double)Element(a, transA, lda, i, p) * Element(b, transB, ldb, p, j);
+				expected[(size_t)i*ldc + j] = (Scalar)(alpha * sum + beta * expected[(size_t)i*ldc + j]);
+			}
+		math::Gemm(transA, transB, m, n, k, alpha, a.data(), lda, b.data(), ldb, beta, c.data(), ldc);
+		for (size_t i = 0; i < c.size(); ++i)
+			CHECK_NEAR(c[i], expected[i], TOLERANCE * k);
+	}
+}
+
+TEST(GemmMatchesNaiveReference)
+{
+	const math::Operation operations[] = { math::NO_TRANSPOSE, math::TRANSPOSE };
+	// Small shapes take the direct path, the large ones the packed and threaded paths with edge tiles
+	const unsigned int shapes[][3] = { { 1, 1, 1 }, { 3, 5, 7 }, { 1, 33, 17 }, { 29, 1, 40 }, { 67, 45, 130 }, { 130, 97, 260 } };
+	for (math::Operation transA : operations)
+		for (math::Operation transB : operations)
+			for (const auto& shape : shapes)
+				for (unsigned int padding : { 0u, 3u })
+					CheckGemm(transA, transB, shape[0], shape[1], shape[2], padding);
+}
+
+TEST(GemvMatchesNaiveReference)
+{
+	std::mt19937 engine(7);
+	const unsigned int m = 37, n = 53, lda = 61;
+	std::vector<Scalar> a = RandomBuffer((size_t)m*lda, engine);
+	for (math::Operation trans : { math::NO_TRANSPOSE, math::TRANSPOSE })
+		for (unsigned int inc : { 1u, 3u })
+		{
+			const unsigned int xSize = trans == math::TRANSPOSE ? m : n, ySize = trans == math::TRANSPOSE ? n : m;
+			std::vector<Scalar> x = RandomBuffer((size_t)xSize*inc, engine);
+			std::vector<Scalar> y = RandomBuffer((size_t)ySize*inc, engine);
+			std::vector<Scalar> expected(y);
+			for (unsigned int i = 0; i < ySize; ++i)
+			{
+				double sum = 0;
+				for (unsigned int p = 0; p < xSize; ++p)
+					sum += (double)Element(a, trans, lda, i, p) * x[(size_t)p*inc];
+				expected[(size_t)i*inc] = (Scalar)(2 * sum + 0.5 * expected[(size_t)i*inc]);
+			}
+			math::Gemv(trans, m, n, (Scalar)2, a.data(), lda, x.data(), inc, (Scalar)0.5, y.data(), inc);
+			for (size_t i = 0; i < y.size(); ++i)
+				CHECK_NEAR(y[i], expected[i], TOLERANCE * xSize);
+		}
+}
+
+TEST(MatrixProductsMatchGemm)
+{
+	Matrix left(19, 23, 0), right(19, 31, 0);
+	left.Randomize();
+	right.Randomize();
+	Matrix product = Matrix::TransposeMultiply(left, right);
+	Matrix transposed = Matrix::Transpose(left) * right;
+	CHECK(product.GetHeight() == 23 && product.GetWidth() == 31);
+	for (unsigned int i = 0; i < product.GetHeight(); ++i)
+		for (unsigned int j = 0; j < product.GetWidth(); ++j)
+			CHECK_NEAR(product.At(i, j), transposed.At(i, j), TOLERANCE * 19);
+}
+
+TEST(QuantizedProductMatchesDequantizedProduct)
+{
+	std::mt19937 engine(11);
+	// Depths around a whole cache line of int8 weights, the padding must not change the zero point corrections
+	for (unsigned int depth : { 1u, 63u, 64u, 65u, 200u })
+		for (unsigned int columns : { 1u, 5u })
+		{
+			std::vector<Scalar> weights = RandomBuffer((size_t)7 * depth, engine);
+			// Rows at the ends of the int8 range: all negative, all positive and a single nonzero weight
+			for (unsigned int p = 0; p < depth; ++p)
+			{
+				weights[p] = -std::abs(weights[p]);
+				weights[depth + p] = std::abs(weights[depth + p]);
+				weights[2 * depth + p] = p == 0 ? (Scalar)-1 : 0;
+			}
+			std::vector<Scalar> inputs = RandomBuffer((size_t)depth*columns, engine);
+			// Activations at the top of their range make the largest pair sums of the byte kernels
+			for (unsigned int p = 0; p < depth; p += 2)
+				inputs[(size_t)p*columns] = 1;
+			const QuantizedMatrix quantized(MatrixView(weights.data(), 7, depth, depth));
+			const MatrixView x(inputs.data(), depth, columns, columns);
+			const Matrix dequantized = quantized.Dequantize();
+			const Matrix expected = dequantized * x;
+			const Matrix product = quantized * x;
+			for (unsigned int kernel = 0; kernel < QuantizedMatrix::GetKernelNames().size(); ++kernel)
+			{
+				const Matrix result = quantized.Multiply(x, kernel);
+				for (unsigned int i = 0; i < 7; ++i)
+					for (unsigned int c = 0; c < columns; ++c)
+						CHECK(result.At(i, c) == product.At(i, c));
+			}
+			for (unsigned int c = 0; c < columns; ++c)
+			{
+				// Only the activations are rounded, by at most one step
+				Scalar minimum = 0, maximum = 0;
+				for (unsigned int p = 0; p < depth; ++p)
+				{
+					minimum = std::min(minimum, inputs[(size_t)p*columns + c]);
+					maximum = std::max(maximum, inputs[(size_t)p*columns + c]);
+				}
+				const double step = (maximum - minimum) / 127;
+				for (unsigned int i = 0; i < 7; ++i)
+				{
+					double weightSum = 0;
+					for (unsigned int p = 0; p < depth; ++p)
+						weightSum += std::abs(dequantized.At(i, p));
+					CHECK_NEAR(product.At(i, c), expected.At(i, c), step * weightSum + TOLERANCE * depth);
+				}
+			}
+		}
+}
@@ -0,0 +1,22 @@
+#include <iostream>
+#include "Test.h"
+
+int main()
+{
+	unsigned int failed = 0;
+	for (const test::TestCase& test : test::GetTests())
+	{
+		try
+		{
+			test.Run();
+			std::cout << "[ OK ] " << test.Name << std::endl;
+		}
+		catch (const std::exception& error)
+		{
+			++failed;
+			std::cout << "[FAIL] " << test.Name << ": " << error.what() << std::endl;
+		}
+	}
+	std::cout << test::GetTests().size() - failed << "/" << test::GetTests().size() << " tests passed" << std::endl;
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+#include "Test.h"
+#include "src/math/Matrix.h"
+
+namespace
+{
+	// rows x columns with padded rows, filled with values that keep division and max interesting
+	Matrix CreateMatrix(unsigned int rows, unsigned int columns, unsigned int stride, Scalar offset)
+	{
+		Matrix matrix(rows, columns, 0, stride);
+		for (unsigned int i = 0; i < rows; ++i)
+			for (unsigned int j = 0; j < columns; ++j)
+				matrix.GetData()[(size_t)i*stride + j] = (Scalar)((i * 7 + j * 3) % 11) - 5 + offset;
+		return matrix;
+	}
+
+	void CheckPaddingIsZero(const Matrix& matrix)
+	{
+		for (unsigned int i = 0; i < matrix.GetHeight(); ++i)
+			for (unsigned int j = matrix.GetWidth(); j < matrix.GetStride(); ++j)
+				CHECK(matrix.GetData()[(size_t)i*matrix.GetStride() + j] == 0);
+	}
+
+	template<typename Expected>
+	void CheckElements(const Matrix& actual, Expected expected)
+	{
+		for (unsigned int i = 0; i < actual.GetHeight(); ++i)
+			for (unsigned int j = 0; j < actual.GetWidth(); ++j)
+				CHECK(actual.At(i, j) == expected(i, j));
+		CheckPaddingIsZero(actual);
+	}
+}
+
+TEST(ExpressionsMatchElementwiseResults)
+{
+	// Contiguous operands take one kernel call, padded ones a call per row
+	for (unsigned int stride : { 13u, Matrix::PaddedStride(13) })
+	{
+		const Matrix a = CreateMatrix(5, 13, stride, 0), b = CreateMatrix(5, 13, 13, (Scalar)0.5);
+		Matrix out(5, 13, 0, stride);
+		out = a + b;
+		CheckElements(out, [&](unsigned int i, unsigned int j) { return a.At(i, j) + b.At(i, j); });
+		out = a - b;
+		CheckElements(out, [&](unsigned int i, unsigned int j) { return a.At(i, j) - b.At(i, j); });
+		out = Matrix::DotProduct(a, b);
+		CheckElements(out, [&](unsigned int i, unsigned int j) { return a.At(i, j) * b.At(i, j); });
+		out = a / b;
+		CheckElements(out, [&](unsigned int i, unsigned int j) { return a.At(i, j) / b.At(i, j); });
+		out = Matrix::Max(a, b);
+		CheckElements(out, [&](unsigned int i, unsigned int j) { return std::max(a.At(i, j), b.At(i, j)); });
+		out = a * (Scalar)3;
+		CheckElements(out, [&](unsigned int i, unsigned int j) { return a.At(i, j) * 3; });
+		out = a / (Scalar)4;
+		CheckElements(out, [&](unsigned int i, unsigned int j) { return a.At(i, j) / 4; });
+		out = 1 - a;
+		CheckElements(out, [&](unsigned int i, unsigned int j) { return 1 - a.At(i, j); });
+		out = Matrix::Map(a, [](Scalar x) { return x * x; });
+		CheckElements(out, [&](unsigned int i, unsigned int j) { return a.At(i, j) * a.At(i, j); });
+		out = a * (Scalar)2 + b;
+		CheckElements(out, [&](unsigned int i, unsigned int j) { return a.At(i, j) * 2 + b.At(i, j); });
+	}
+}
+
+TEST(ExpressionsMayReferToTheirTarget)
+{
+	Matrix a = CreateMatrix(4, 9, Matrix::PaddedStride(9), 0);
+	const Matrix original(a);
+	a = a * (Scalar)2;
+	a = Matrix::DotProduct(a, a);
+	CheckElements(a, [&](unsigned int i, unsigned int j) { return 4 * original.At(i, j) * original.At(i, j); });
+}
+
+TEST(ScaledAccumulationMatchesExpression)
+{
+	Matrix a = CreateMatrix(6, 10, Matrix::PaddedStride(10), 0);
+	const Matrix x = CreateMatrix(6, 10, 10, 1);
+	const Matrix original(a);
+	a += x * (Scalar)0.5;
+	a -= (Scalar)0.25 * x;
+	CheckElements(a, [&](unsigned int i, unsigned int j) { return original.At(i, j) + x.At(i, j) * (Scalar)0.25; });
+}
+
+TEST(ViewsLeaveTheElementsBetweenRowsAlone)
+{
+	// 2 x 3 view with stride 5, the two elements after each row belong to someone else
+	Scalar buffer[] = { 1, 1, 1, 100, 100, 1, 1, 1, 100, 100 };
+	Matrix view = Matrix::View(buffer, 2, 3, 5);
+	CHECK(view.IsView());
+	CHECK(view.Sum() == 6);
+	view *= 2;
+	view /= 4;
+	view += view;
+	view -= Matrix(2, 3, (Scalar)0.5);
+	view.DotProduct(Matrix(2, 3, 2));
+	CHECK(view.Sum() == 6);
+	const Matrix copy(view);
+	CHECK(!copy.IsView() && copy.Sum() == 6);
+	CheckPaddingIsZero(copy);
+	Matrix assigned(3, 2, 0);
+	assigned = view;
+	CHECK(assigned.Sum() == 6);
+	CheckPaddingIsZero(assigned);
+	view.ZeroOut();
+	CHECK(view.Sum() == 0);
+	for (unsigned int i : { 3, 4, 8, 9 })
+		CHECK(buffer[i] == 100);
+}
+
+TEST(MatricesOfTheViewShapeAreWrittenThrough)
+{
+	Scalar buffer[] = { 0, 0, 0, 100, 100, 0, 0, 0, 100, 100 };
+	Matrix view = Matrix::View(buffer, 2, 3, 5);
+	view = Matrix(2, 3, 1);
+	CHECK(view.GetData() == buffer && buffer[0] == 1 && buffer[7] == 1);
+	Matrix other(2, 3, 2);
+	view = std::move(other);
+	CHECK(view.GetData() == buffer && buffer[2] == 2 && buffer[5] == 2);
+	view = Matrix(3, 3, 3);
+	CHECK(!view.IsView() && view.Sum() == 27);
+	CHECK(buffer[3] == 100 && buffer[0] == 2);
+}
@@ -0,0 +1,154 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "Test.h"
+#include "NeuralNetwork.h"
+
+namespace
+{
+	const char* MODEL_FILE = "SerializationTests.bin";
+
+	nn::NeuralNetwork CreateNetwork()
+	{
+		return nn::NeuralNetwork(5, {
+			nn::Layer(5, 9, nn::activation::TANH),
+			nn::Layer(9, 3, nn::activation::SIGMOID)
+		}, nn::initialization::XAVIER_NORMAL, nn::loss::QUADRATIC);
+	}
+
+	std::vector<std::vector<Scalar>> CreateInputs()
+	{
+		std::vector<std::vector<Scalar>> inputs;
+		for (unsigned int i = 0; i < 8; ++i)
+		{
+			std::vector<Scalar> input;
+			for (unsigned int j = 0; j < 5; ++j)
+				input.push_back((Scalar)((i * 5 + j) % 7) / 7 - (Scalar)0.4);
+			inputs.push_back(input);
+		}
+		return inputs;
+	}
+
+	// Saves and loads model and checks that the loaded model computes exactly the same outputs
+	void CheckRoundTrip(nn::NeuralNetwork& model)
+	{
+		model.SaveModel(MODEL_FILE);
+		nn::NeuralNetwork loaded = nn::NeuralNetwork::LoadModel(MODEL_FILE);
+		std::remove(MODEL_FILE);
+		for (const std::vector<Scalar>& input : CreateInputs())
+		{
+			nn::Output expected = model.Eval(input);
+			nn::Output actual = loaded.Eval(input);
+			CHECK(actual.Value == expected.Value);
+			CHECK(actual.Argmax == expected.Argmax);
+		}
+	}
+}
+
+TEST(SaveLoadRoundTrip)
+{
+	nn::NeuralNetwork model = CreateNetwork();
+	CheckRoundTrip(model);
+}
+
+TEST(LoadedMatricesHaveZeroPadding)
+{
+	const char* MATRIX_FILE = "SerializationTests.matrix";
+	Matrix matrix(3, 5, 0);
+	for (unsigned int i = 0; i < 3; ++i)
+		for (unsigned int j = 0; j < 5; ++j)
+			matrix.GetData()[(size_t)i*matrix.GetStride() + j] = (Scalar)(i * 5 + j + 1);
+	{
+		std::ofstream outfile(MATRIX_FILE, std::ios::binary);
+		matrix.SaveMatrix(outfile);
+	}
+	{
+		// Leaves a dirty block of the loaded size in the workspace
+		Matrix dirty(3, Matrix::PaddedStride(5), 7);
+	}
+	std::ifstream infile(MATRIX_FILE, std::ios::binary);
+	Matrix loaded = Matrix::LoadMatrix(infile);
+	infile.close();
+	std::remove(MATRIX_FILE);
+	CHECK(loaded.GetStride() == Matrix::PaddedStride(5));
+	for (unsigned int i = 0; i < 3; ++i)
+	{
+		for (unsigned int j = 0; j < 5; ++j)
+			CHECK(loaded.At(i, j) == matrix.At(i, j));
+		for (unsigned int j = 5; j < loaded.GetStride(); ++j)
+			CHECK(loaded.GetData()[(size_t)i*loaded.GetStride() + j] == 0);
+	}
+}
+
+TEST(SaveLoadRoundTripFlat)
+{
+	nn::NeuralNetwork model = CreateNetwork();
+	model.Flatten();
+	CheckRoundTrip(model);
+}
+
+TEST(SaveLoadRoundTripFloat16)
+{
+	nn::NeuralNetwork model = CreateNetwork();
+	model.Compress(math::FLOAT16);
+	CheckRoundTrip(model);
+}
+
+TEST(SaveLoadRoundTripBFloat16)
+{
+	nn::NeuralNetwork model = CreateNetwork();
+	model.Compress(math::BFLOAT16);
+	CheckRoundTrip(model);
+}
+
+TEST(CompressedModelIsSmaller)
+{
+	nn::NeuralNetwork model = CreateNetwork();
+	model.SaveModel(MODEL_FILE);
+	std::ifstream full(MODEL_FILE, std::ios::binary | std::ios::ate);
+	const std::streamoff fullSize = full.tellg();
+	full.close();
+	model.Compress(math::FLOAT16);
+	model.SaveModel(MODEL_FILE);
+	std::ifstream compressed(MODEL_FILE, std::ios::binary | std::ios::ate);
+	const std::streamoff compressedSize = compressed.tellg();
+	compressed.close();
+	std::remove(MODEL_FILE);
+	CHECK(compressedSize < fullSize);
+}
+
+TEST(SaveLoadEmptyNetwork)
+{
+	nn::NeuralNetwork model(3, {}, nn::initialization::NONE, nn::loss::MSE);
+	model.SaveModel(MODEL_FILE);
+	nn::NeuralNetwork loaded = nn::NeuralNetwork::LoadModel(MODEL_FILE);
+	std::ifstream saved(MODEL_FILE, std::ios::binary);
+	const std::string expected((std::istreambuf_iterator<char>(saved)), std::istreambuf_iterator<char>());
+	saved.close();
+	loaded.SaveModel(MODEL_FILE);
+	std::ifstream resaved(MODEL_FILE, std::ios::binary);
+	const std::string actual((std::istreambuf_iterator<char>(resaved)), std::istreambuf_iterator<char>());
+	resaved.close();
+	std::remove(MODEL_FILE);
+	CHECK(!expected.empty() && actual == expected);
+}
+
+TEST(QuantizedModelIsSavedDequantized)
+{
+	nn::NeuralNetwork model = CreateNetwork();
+	model.SaveModel(MODEL_FILE);
+	nn::NeuralNetwork quantized = nn::NeuralNetwork::LoadModel(MODEL_FILE);
+	quantized.Flatten();
+	quantized.Quantize();
+	CHECK(!quantized.IsFlat());
+	for (const std::vector<Scalar>& input : CreateInputs())
+		CHECK_NEAR(quantized.Eval(input).Value, model.Eval(input).Value, 0.05);
+	// The saved weights are the ones Decompress leaves
+	quantized.SaveModel(MODEL_FILE);
+	nn::NeuralNetwork loaded = nn::NeuralNetwork::LoadModel(MODEL_FILE);
+	std::remove(MODEL_FILE);
+	quantized.Decompress();
+	for (const std::vector<Scalar>& input : CreateInputs())
+		CHECK(loaded.Eval(input).Value == quantized.Eval(input).Value);
+}
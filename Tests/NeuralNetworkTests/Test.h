@@ -0,0 +1,63 @@
+#pragma once
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace test
+{
+	struct TestCase
+	{
+		const char* Name;
+		void(*Run)();
+	};
+
+	struct TestFailure : std::runtime_error
+	{
+		TestFailure(const std::string& message) : std::runtime_error(message) {}
+	};
+
+	inline std::vector<TestCase>& GetTests()
+	{
+		static std::vector<TestCase> tests;
+		return tests;
+	}
+
+	struct Registrar
+	{
+		Registrar(const char* name, void(*run)()) { GetTests().push_back({ name, run }); }
+	};
+
+	inline void Check(bool condition, const char* expression, const char* file, int line)
+	{
+		if (condition)
+			return;
+		std::ostringstream message;
+		message << file << ":" << line << ": CHECK(" << expression << ") failed";
+		throw TestFailure(message.str());
+	}
+
+	inline void CheckNear(double actual, double expected, double tolerance, const char* expression, const char* file, int line)
+	{
+		if (std::abs(actual - expected) <= tolerance)
+			return;
+		std::ostringstream message;
+		message << file << ":" << line << ": CHECK_NEAR(" << expression << ") failed, " << actual << " vs " << expected;
+		throw TestFailure(message.str());
+	}
+}
+
+// Registers a test that main runs, a failed check ends the test with a TestFailure
+#define TEST(name) \
+	static void name(); \
+	static test::Registrar name##Registrar(#name, name); \
+	static void name()
+
+#define CHECK(condition) test::Check((condition), #condition, __FILE__, __LINE__)
+#define CHECK_NEAR(actual, expected, tolerance) test::CheckNear((actual), (expected), (tolerance), #actual ", " #expected, __FILE__, __LINE__)
+#define CHECK_THROWS(statement) \
+	do { \
+		bool thrown = false; \
+		try { statement; } catch (const std::exception&) { thrown = true; } \
+		test::Check(thrown, #statement " throws", __FILE__, __LINE__); \
+	} while (false)
@@ -0,0 +1,28 @@
+#include <atomic>
+#include <stdexcept>
+#include "Test.h"
+#include "src/math/ThreadPool.h"
+
+TEST(PoolRethrowsTaskErrors)
+{
+	math::ThreadPool& pool = math::ThreadPool::GetInstance();
+	const unsigned int count = 4 * pool.GetThreadCount() + 1;
+	bool thrown = false;
+	try
+	{
+		pool.ParallelFor(count, [](unsigned int i)
+		{
+			if (i == 3)
+				throw std::runtime_error("Task failed");
+		});
+	}
+	catch (const std::runtime_error&)
+	{
+		thrown = true;
+	}
+	CHECK(thrown);
+	// The pool runs later loops again
+	std::atomic<unsigned int> sum(0);
+	pool.ParallelFor(count, [&sum](unsigned int i) { sum += i; });
+	CHECK(sum == count * (count - 1) / 2);
+}
@@ -0,0 +1,274 @@
+#include <cstdio>
+#include <random>
+#include "Test.h"
+#include "NeuralNetwork.h"
+
+namespace
+{
+	const char* MODEL_FILE = "TrainingTests.bin";
+	const unsigned int INPUT_SIZE = 24;
+	const unsigned int CLASS_COUNT = 4;
+
+	// Trains copies of one randomly initialized network, so that every run starts from the same weights
+	class Trainer
+	{
+	private:
+		nn::NeuralNetwork m_Model;
+	public:
+		Trainer() : m_Model(INPUT_SIZE, {
+			nn::Layer(INPUT_SIZE, 16, nn::activation::RELU),
+			nn::Layer(16, CLASS_COUNT, nn::activation::SIGMOID)
+		}, nn::initialization::HE_NORMAL, nn::loss::QUADRATIC)
+		{
+			m_Model.SaveModel(MODEL_FILE);
+		}
+		~Trainer() { std::remove(MODEL_FILE); }
+
+		nn::NeuralNetwork CreateModel() const
+		{
+			nn::NeuralNetwork model = nn::NeuralNetwork::LoadModel(MODEL_FILE);
+			model.SetShuffleSeed(3);
+			return model;
+		}
+	};
+
+	// Samples with about one input in four set and a one-hot target
+	std::vector<nn::TrainingData> CreateSamples(bool sparse)
+	{
+		std::mt19937 engine(5);
+		std::uniform_real_distribution<double> distribution(0, 1);
+		std::vector<nn::TrainingData> samples;
+		for (unsigned int i = 0; i < 96; ++i)
+		{
+			std::vector<Scalar> input(INPUT_SIZE, 0);
+			std::vector<unsigned int> indices;
+			std::vector<Scalar> values;
+			for (unsigned int j = 0; j < INPUT_SIZE; ++j)
+				if (distribution(engine) < 0.25)
+				{
+					input[j] = (Scalar)distribution(engine);
+					indices.push_back(j);
+					values.push_back(input[j]);
+				}
+			std::vector<Scalar> target(CLASS_COUNT, 0);
+			target[i % CLASS_COUNT] = 1;
+			if (sparse)
+				samples.emplace_back(SparseMatrix::BuildRowVector(INPUT_SIZE, indices, values), target);
+			else
+				samples.emplace_back(input, target);
+		}
+		return samples;
+	}
+
+	std::vector<nn::Output> Evaluate(nn::NeuralNetwork& model)
+	{
+		std::vector<nn::Output> outputs;
+		for (const nn::TrainingData& sample : CreateSamples(false))
+			outputs.push_back(model.Eval(sample.Inputs));
+		return outputs;
+	}
+
+	double MaxDifference(const std::vector<nn::Output>& left, const std::vector<nn::Output>& right)
+	{
+		double difference = 0;
+		for (size_t i = 0; i < left.size(); ++i)
+			difference = std::max(difference, (double)std::abs(left[i].Value - right[i].Value));
+		return difference;
+	}
+
+	// Share of the samples whose target class the model picks
+	double Accuracy(nn::NeuralNetwork& model, const std::vector<nn::TrainingData>& samples)
+	{
+		unsigned int correct = 0;
+		for (const nn::TrainingData& sample : samples)
+			if (sample.Target[model.Eval(sample.Inputs).Argmax] == 1)
+				correct++;
+		return (double)correct / samples.size();
+	}
+
+	const double TOLERANCE = sizeof(Scalar) == sizeof(float) ? 1e-4 : 1e-10;
+}
+
+TEST(SparseTrainingMatchesDense)
+{
+	Trainer trainer;
+	nn::NeuralNetwork dense = trainer.CreateModel();
+	nn::NeuralNetwork sparse = trainer.CreateModel();
+	nn::optimizer::GradientDescent denseOptimizer(0.05), sparseOptimizer(0.05);
+	dense.Train(denseOptimizer, 4, CreateSamples(false), 8);
+	sparse.Train(sparseOptimizer, 4, CreateSamples(true), 8);
+	CHECK(MaxDifference(Evaluate(dense), Evaluate(sparse)) <= TOLERANCE);
+}
+
+TEST(ParallelTrainingIsDeterministic)
+{
+	Trainer trainer;
+	const std::vector<nn::TrainingData> samples = CreateSamples(false);
+	std::vector<nn::Output> first, serial;
+	for (unsigned int run = 0; run < 3; ++run)
+	{
+		nn::NeuralNetwork model = trainer.CreateModel();
+		nn::optimizer::Adam optimizer(0.01);
+		model.Train(optimizer, 3, samples, 16, nn::regularizer::L2, 4);
+		std::vector<nn::Output> outputs = Evaluate(model);
+		if (run == 0)
+			first = outputs;
+		else
+			CHECK(MaxDifference(first, outputs) == 0);
+	}
+	// Other shard counts only sum the gradients in another order
+	nn::NeuralNetwork model = trainer.CreateModel();
+	nn::optimizer::Adam optimizer(0.01);
+	model.Train(optimizer, 3, samples, 16, nn::regularizer::L2, 1);
+	CHECK(MaxDifference(first, Evaluate(model)) <= TOLERANCE * 100);
+}
+
+TEST(DatasetTrainingMatchesSamples)
+{
+	Trainer trainer;
+	const std::vector<nn::TrainingData> samples = CreateSamples(false);
+	nn::NeuralNetwork fromSamples = trainer.CreateModel();
+	nn::NeuralNetwork fromDataset = trainer.CreateModel();
+	nn::optimizer::Momentum samplesOptimizer(0.05), datasetOptimizer(0.05);
+	fromSamples.Train(samplesOptimizer, 3, samples, 8, nn::regularizer::NONE, 2);
+	fromDataset.Train(datasetOptimizer, 3, nn::Dataset(samples), 8, nn::regularizer::NONE, 2);
+	CHECK(MaxDifference(Evaluate(fromSamples), Evaluate(fromDataset)) == 0);
+}
+
+TEST(FlatTrainingMatchesLayerTraining)
+{
+	Trainer trainer;
+	const std::vector<nn::TrainingData> samples = CreateSamples(false);
+	nn::NeuralNetwork layers = trainer.CreateModel();
+	nn::NeuralNetwork flat = trainer.CreateModel();
+	flat.Flatten();
+	nn::optimizer::Adam layersOptimizer(0.01), flatOptimizer(0.01);
+	layers.Train(layersOptimizer, 3, samples, 16, nn::regularizer::L2, 3);
+	flat.Train(flatOptimizer, 3, samples, 16, nn::regularizer::L2, 3);
+	CHECK(flat.IsFlat());
+	CHECK(MaxDifference(Evaluate(layers), Evaluate(flat)) == 0);
+	// Compressing gives the layers storage of their own before the flat buffer is freed
+	layers.Compress(math::FLOAT16);
+	flat.Compress(math::FLOAT16);
+	CHECK(!flat.IsFlat());
+	CHECK(MaxDifference(Evaluate(layers), Evaluate(flat)) == 0);
+}
+
+TEST(PrefetchedTrainingMatchesGatheredTraining)
+{
+	Trainer trainer;
+	for (bool sparse : { false, true })
+	{
+		const std::vector<nn::TrainingData> samples = CreateSamples(sparse);
+		nn::NeuralNetwork gathered = trainer.CreateModel();
+		nn::NeuralNetwork prefetched = trainer.CreateModel();
+		prefetched.SetPrefetch(3, 2);
+		nn::optimizer::Adam gatheredOptimizer(0.01), prefetchedOptimizer(0.01);
+		gathered.Train(gatheredOptimizer, 3, samples, 16, nn::regularizer::NONE, 2);
+		prefetched.Train(prefetchedOptimizer, 3, samples, 16, nn::regularizer::NONE, 2);
+		CHECK(MaxDifference(Evaluate(gathered), Evaluate(prefetched)) == 0);
+	}
+}
+
+TEST(HogwildTrainingLearns)
+{
+	Trainer trainer;
+	std::vector<nn::TrainingData> samples = CreateSamples(false);
+	// The class is marked in the inputs, so that the samples can be learned
+	for (unsigned int i = 0; i < samples.size(); ++i)
+		samples[i].Inputs[i % CLASS_COUNT] += 1;
+	nn::optimizer::GradientDescent gradientDescent(0.5);
+	nn::optimizer::Momentum momentum(0.1);
+	for (nn::optimizer::Optimizer* optimizer : { (nn::optimizer::Optimizer*)&gradientDescent, (nn::optimizer::Optimizer*)&momentum })
+	{
+		nn::NeuralNetwork model = trainer.CreateModel();
+		model.Train(*optimizer, 30, samples, 4, nn::regularizer::NONE, 4, nn::ParallelMode::HOGWILD);
+		CHECK(Accuracy(model, samples) >= 0.9);
+	}
+}
+
+TEST(HogwildTrainingRejectsOptimizersWithSharedState)
+{
+	Trainer trainer;
+	const std::vector<nn::TrainingData> samples = CreateSamples(false);
+	const std::vector<std::shared_ptr<nn::optimizer::Optimizer>> optimizers = {
+		std::make_shared<nn::optimizer::Nesterov>(0.01), std::make_shared<nn::optimizer::Adagrad>(0.01),
+		std::make_shared<nn::optimizer::RMSProp>(0.01), std::make_shared<nn::optimizer::Adadelta>(0.01),
+		std::make_shared<nn::optimizer::Adam>(0.01), std::make_shared<nn::optimizer::Nadam>(0.01),
+		std::make_shared<nn::optimizer::Adamax>(0.01), std::make_shared<nn::optimizer::AMSGrad>(0.01),
+		std::make_shared<nn::optimizer::Adabound>(0.01), std::make_shared<nn::optimizer::AMSBound>(0.01)
+	};
+	for (const std::shared_ptr<nn::optimizer::Optimizer>& optimizer : optimizers)
+	{
+		nn::NeuralNetwork model = trainer.CreateModel();
+		bool rejected = false;
+		try
+		{
+			model.Train(*optimizer, 1, samples, 8, nn::regularizer::NONE, 2, nn::ParallelMode::HOGWILD);
+		}
+		catch (const std::invalid_argument&)
+		{
+			rejected = true;
+		}
+		CHECK(rejected);
+	}
+}
+
+TEST(HogwildTrainingWithMoreThreadsThanSamples)
+{
+	Trainer trainer;
+	const std::vector<nn::TrainingData> samples = CreateSamples(false);
+	const std::vector<nn::TrainingData> few(samples.begin(), samples.begin() + 3);
+	nn::NeuralNetwork model = trainer.CreateModel();
+	const std::vector<nn::Output> before = Evaluate(model);
+	nn::optimizer::GradientDescent optimizer(0.5);
+	model.Train(optimizer, 2, few, 4, nn::regularizer::NONE, 8, nn::ParallelMode::HOGWILD);
+	const std::vector<nn::Output> after = Evaluate(model);
+	CHECK(after.size() == before.size());
+	bool changed = false;
+	for (size_t i = 0; i < after.size(); ++i)
+	{
+		CHECK(after[i].Value >= 0 && after[i].Value <= 1);
+		changed = changed || after[i].Value != before[i].Value;
+	}
+	CHECK(changed);
+}
+
+TEST(LossesSkipThePaddingOfTheirRows)
+{
+	const unsigned int rows = 3, columns = 5;
+	Matrix padded(rows, columns, 0, Matrix::PaddedStride(columns));
+	Matrix tight(rows, columns, 0);
+	Matrix target(rows, columns, 0);
+	for (unsigned int i = 0; i < rows; ++i)
+		for (unsigned int j = 0; j < columns; ++j)
+		{
+			const Scalar value = (Scalar)(i * columns + j + 1) / (rows * columns + 2);
+			padded.GetData()[(size_t)i*padded.GetStride() + j] = value;
+			tight.GetData()[(size_t)i*tight.GetStride() + j] = value;
+			target.GetData()[(size_t)i*target.GetStride() + j] = (Scalar)((i + j) % 2);
+		}
+	CHECK(padded.GetStride() != tight.GetStride());
+	for (nn::loss::Type type : { nn::loss::CROSS_ENTROPY, nn::loss::NLL })
+	{
+		std::shared_ptr<nn::loss::LossFunction> loss = nn::LossFunctionFactory::BuildLossFunction(type);
+		const double expected = loss->GetLoss(tight, target);
+		CHECK(expected > 0);
+		CHECK_NEAR(loss->GetLoss(padded, target), expected, TOLERANCE);
+		CHECK_NEAR(loss->GetLoss(tight, padded), loss->GetLoss(tight, tight), TOLERANCE);
+	}
+}
+
+#ifdef _DEBUG
+TEST(PrefetchErrorsReachTheTrainingThread)
+{
+	Trainer trainer;
+	std::vector<nn::TrainingData> samples = CreateSamples(true);
+	// Appending this sample to the others throws while a loader gathers its batch
+	samples[37] = nn::TrainingData(SparseMatrix::BuildRowVector(INPUT_SIZE + 1, { 0 }, { 1 }), samples[37].Target);
+	nn::NeuralNetwork model = trainer.CreateModel();
+	model.SetPrefetch(3, 2);
+	nn::optimizer::Adam optimizer(0.01);
+	CHECK_THROWS(model.Train(optimizer, 2, samples, 16, nn::regularizer::NONE, 2));
+}
+#endif // _DEBUG
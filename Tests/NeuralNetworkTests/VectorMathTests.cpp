@@ -0,0 +1,68 @@
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+#include "Test.h"
+#include "src/math/Scalar.h"
+#include "src/math/VectorMath.h"
+
+namespace
+{
+	// Distance from the exact value in units of the spacing of Scalar around it
+	double Ulps(Scalar actual, long double exact)
+	{
+		const Scalar rounded = (Scalar)exact;
+		if (std::isinf(rounded) || std::isinf(actual))
+			return actual == rounded ? 0 : std::numeric_limits<double>::infinity();
+		const Scalar magnitude = std::abs(rounded);
+		const Scalar spacing = magnitude == 0 ? std::numeric_limits<Scalar>::denorm_min()
+			: std::nextafter(magnitude, std::numeric_limits<Scalar>::infinity()) - magnitude;
+		return (double)(std::abs((long double)actual - exact) / spacing);
+	}
+
+	template<typename Kernel, typename Exact>
+	double MaxUlps(Kernel kernel, Exact exact, double min, double max)
+	{
+		std::mt19937 engine(1);
+		std::uniform_real_distribution<double> distribution(min, max);
+		std::vector<Scalar> x(4096), y(x.size());
+		for (Scalar& value : x)
+			value = (Scalar)distribution(engine);
+		kernel(x.size(), x.data(), y.data());
+		double ulps = 0;
+		for (size_t i = 0; i < x.size(); ++i)
+			ulps = std::max(ulps, Ulps(y[i], exact((long double)x[i])));
+		return ulps;
+	}
+
+	const double EXP_BOUND = 1.1, LOG_BOUND = 2, DIVISION_BOUND = 4;
+}
+
+TEST(FastKernelsStayWithinTheirUlpBounds)
+{
+	math::SetAccuracy(math::FAST);
+	const double expMin = sizeof(Scalar) == sizeof(float) ? -103.9 : -745.1;
+	const double expMax = sizeof(Scalar) == sizeof(float) ? 88.7 : 709.7;
+	auto exp = [](long double x) { return std::exp(x); };
+	auto sigmoid = [](long double x) { return 1 / (1 + std::exp(-x)); };
+	CHECK(MaxUlps([](size_t n, const Scalar* a, Scalar* out) { math::kernel::Exp(n, a, out); }, exp, expMin, expMax) <= EXP_BOUND);
+	// Only the subnormal results
+	CHECK(MaxUlps([](size_t n, const Scalar* a, Scalar* out) { math::kernel::Exp(n, a, out); }, exp, expMin, expMin + 37) <= EXP_BOUND);
+	CHECK(MaxUlps([](size_t n, const Scalar* a, Scalar* out) { math::kernel::Log(n, a, out); }, [](long double x) { return std::log(x); }, 1e-3, 1e3) <= LOG_BOUND);
+	CHECK(MaxUlps([](size_t n, const Scalar* a, Scalar* out) { math::kernel::Tanh(n, a, out); }, [](long double x) { return std::tanh(x); }, -5, 5) <= DIVISION_BOUND);
+	CHECK(MaxUlps([](size_t n, const Scalar* a, Scalar* out) { math::kernel::Sigmoid(n, a, out); }, sigmoid, expMin, 40) <= DIVISION_BOUND);
+}
+
+TEST(FastExpKeepsSubnormalResults)
+{
+	math::SetAccuracy(math::FAST);
+	const Scalar x[] = { (Scalar)-708.287, (Scalar)-86.67, (Scalar)-745.2, (Scalar)-104 };
+	Scalar y[4], sigmoid[4];
+	math::kernel::Exp(4, x, y);
+	math::kernel::Sigmoid(4, x, sigmoid);
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		CHECK(Ulps(y[i], std::exp((long double)x[i])) <= EXP_BOUND);
+		CHECK(Ulps(sigmoid[i], 1 / (1 + std::exp(-(long double)x[i]))) <= DIVISION_BOUND);
+	}
+}
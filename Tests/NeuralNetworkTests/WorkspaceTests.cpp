@@ -0,0 +1,124 @@
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <thread>
+#include "Test.h"
+#include "NeuralNetwork.h"
+
+namespace
+{
+	std::atomic<unsigned long long> newCount(0);
+
+	// Every allocation of the test program, the workspace counts the buffers it takes from the heap itself
+	unsigned long long GetAllocationCount()
+	{
+		return newCount + math::Workspace::GetHeapAllocationCount();
+	}
+
+	// Adam that records the allocation count after every training step, layer 0 is updated last
+	class StepRecorder : public nn::optimizer::Optimizer
+	{
+	private:
+		nn::optimizer::Adam m_Adam;
+	public:
+		std::vector<unsigned long long> Allocations;
+		std::vector<unsigned int> Epochs;
+
+		StepRecorder(unsigned int steps) : Optimizer(0.01), m_Adam(0.01)
+		{
+			Allocations.reserve(steps);
+			Epochs.reserve(steps);
+		}
+
+		void UpdateLayer(nn::Layer& layer, Matrix& deltaWeight, Matrix& deltaBias, int layerIndex, unsigned int epoch) override
+		{
+			m_Adam.UpdateLayer(layer, deltaWeight, deltaBias, layerIndex, epoch);
+			if (layerIndex != 0)
+				return;
+			Allocations.push_back(GetAllocationCount());
+			Epochs.push_back(epoch);
+		}
+
+		void Reset() override { m_Adam.Reset(); }
+	};
+
+	struct MatrixHolder
+	{
+		Matrix Value;
+	};
+
+	// Destroyed after main returns, and so after the main thread's workspace free lists
+	std::unique_ptr<nn::NeuralNetwork> staticNetwork;
+	Matrix staticMatrix;
+}
+
+void* operator new(size_t size)
+{
+	newCount++;
+	if (void* block = std::malloc(size == 0 ? 1 : size))
+		return block;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept
+{
+	std::free(block);
+}
+
+void operator delete(void* block, size_t) noexcept
+{
+	std::free(block);
+}
+
+// A leak or use after free here shows up under a memory checker such as AddressSanitizer, or as a crash at exit
+TEST(MatricesMayOutliveTheWorkspace)
+{
+	std::thread([]()
+	{
+		// Constructed before the thread's free lists, so destroyed after them
+		thread_local MatrixHolder holder;
+		{
+			// Leaves a cached block of the size used below
+			Matrix temporary(16, 16, 2);
+		}
+		holder.Value = Matrix(16, 16, 1);
+	}).join();
+
+	staticNetwork.reset(new nn::NeuralNetwork(4, { nn::Layer(4, 3, nn::activation::SIGMOID) }, nn::initialization::XAVIER_NORMAL, nn::loss::MSE));
+	staticNetwork->Flatten();
+	staticMatrix = Matrix(8, 8, 3);
+	CHECK(staticNetwork->Eval({ 1, 2, 3, 4 }).Value > 0);
+}
+
+// The first step of an epoch may allocate the optimizer state Train resets, every later step reuses the buffers of the steps before
+// Each pool thread fills its own free lists the first time it runs a shard, so the first half of the epochs is warm-up
+TEST(SteadyStateTrainingDoesNotAllocate)
+{
+	std::mt19937 engine(7);
+	std::uniform_real_distribution<double> distribution(0, 1);
+	std::vector<nn::TrainingData> samples;
+	for (unsigned int i = 0; i < 160; ++i)
+	{
+		std::vector<Scalar> input(32);
+		for (Scalar& value : input)
+			value = (Scalar)distribution(engine);
+		std::vector<Scalar> target(4, 0);
+		target[i % 4] = 1;
+		samples.emplace_back(input, target);
+	}
+	for (unsigned int threads : { 1, 4 })
+		for (unsigned int prefetch : { 0, 3 })
+		{
+			nn::NeuralNetwork model(32, { nn::Layer(32, 64, nn::activation::RELU), nn::Layer(64, 4, nn::activation::SIGMOID) },
+				nn::initialization::HE_NORMAL, nn::loss::QUADRATIC);
+			model.SetPrefetch(prefetch, 2);
+			StepRecorder optimizer(120);
+			model.Train(optimizer, 12, samples, 16, nn::regularizer::L2, threads);
+			CHECK(optimizer.Allocations.size() == 120);
+			for (size_t step = 1; step < optimizer.Allocations.size(); ++step)
+				if (optimizer.Epochs[step] > 6 && optimizer.Epochs[step] == optimizer.Epochs[step - 1])
+					CHECK(optimizer.Allocations[step] == optimizer.Allocations[step - 1]);
+		}
+}